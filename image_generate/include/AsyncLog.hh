@@ -0,0 +1,235 @@
+/* ===================================================
+ *  file:       AsyncLog.hh
+ * ---------------------------------------------------
+ *  purpose:	logging out of the frame path: messages
+ *              are formatted into a lock-free ring and
+ *              written to stderr by a background thread
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_ASYNC_LOG_HH
+#define _FRAMEWORK_ASYNC_LOG_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdarg.h>
+#include <stdint.h>
+#include <atomic>
+#include <thread>
+
+/* ====== DEFINITIONS ====== */
+#define ASYNC_LOG_NO_SLOTS      1024        // number of messages the ring holds, power of 2
+#define ASYNC_LOG_MSG_SIZE      248         // longest message incl. terminating zero, longer ones are cut
+
+/**
+* messages below this level are removed at compile time; debug messages are kept unless NDEBUG is set,
+* as it is by the default (Release) build
+*/
+#ifndef FWLOG_MIN_LEVEL
+#ifdef NDEBUG
+#define FWLOG_MIN_LEVEL         1
+#else
+#define FWLOG_MIN_LEVEL         0
+#endif
+#endif
+
+/**
+* log a message; the arguments are not evaluated if the level is disabled at run time
+*/
+#define FWLOG( _level, ... )                                                                \
+    do {                                                                                    \
+        if ( Framework::AsyncLog::enabled( _level ) )                                       \
+            Framework::AsyncLog::instance().log( _level, __VA_ARGS__ );                     \
+    } while ( 0 )
+
+/**
+* log a message at most once per interval, per call site; the number of suppressed
+* messages is appended to the next one which is logged
+*/
+#define FWLOG_RATE( _level, _intervalMs, ... )                                              \
+    do {                                                                                    \
+        static Framework::LogRateLimit _limit;                                              \
+        unsigned int _suppressed = 0;                                                       \
+        if ( Framework::AsyncLog::enabled( _level ) && _limit.allow( ( _intervalMs ) * 1000000ull, _suppressed ) ) \
+            Framework::AsyncLog::instance().logSuppressed( _level, _suppressed, __VA_ARGS__ ); \
+    } while ( 0 )
+
+/**
+* a message removed at compile time; the dead branch keeps its arguments checked and used
+*/
+#define FWLOG_NONE( _level, ... )                                                           \
+    do {                                                                                    \
+        if ( 0 )                                                                            \
+            Framework::AsyncLog::instance().log( _level, __VA_ARGS__ );                     \
+    } while ( 0 )
+
+#if FWLOG_MIN_LEVEL <= 0
+#define FWLOG_DEBUG( ... )      FWLOG( Framework::LOG_LEVEL_DEBUG, __VA_ARGS__ )
+#else
+#define FWLOG_DEBUG( ... )      FWLOG_NONE( Framework::LOG_LEVEL_DEBUG, __VA_ARGS__ )
+#endif
+
+#if FWLOG_MIN_LEVEL <= 1
+#define FWLOG_INFO( ... )       FWLOG( Framework::LOG_LEVEL_INFO, __VA_ARGS__ )
+#else
+#define FWLOG_INFO( ... )       FWLOG_NONE( Framework::LOG_LEVEL_INFO, __VA_ARGS__ )
+#endif
+
+#define FWLOG_WARN( ... )       FWLOG( Framework::LOG_LEVEL_WARN, __VA_ARGS__ )
+#define FWLOG_ERROR( ... )      FWLOG( Framework::LOG_LEVEL_ERROR, __VA_ARGS__ )
+
+namespace Framework
+{
+
+/**
+* levels of the messages
+*/
+enum LogLevel
+{
+    LOG_LEVEL_DEBUG = 0,
+    LOG_LEVEL_INFO,
+    LOG_LEVEL_WARN,
+    LOG_LEVEL_ERROR
+};
+
+/**
+* rate limit of a single message; lock-free, so that it may be shared by all threads
+*/
+class LogRateLimit
+{
+    public:
+        /**
+        * constructor; constant initialization spares the static limits of the call sites a guard
+        */
+        constexpr LogRateLimit() : mNext( 0 ), mSuppressed( 0 )
+        {
+        }
+
+        /**
+        * check whether a message may be logged now
+        * @param intervalNs  minimum time between two messages
+        * @param suppressed  receives the number of messages suppressed since the last one logged
+        * @return true if the message is to be logged
+        */
+        bool allow( uint64_t intervalNs, unsigned int & suppressed );
+
+    private:
+        std::atomic<uint64_t>      mNext;           // earliest time of the next message        @unit ns
+        std::atomic<unsigned int>  mSuppressed;
+};
+
+/**
+* logger with a bounded multi-producer ring; a producer only formats its message into
+* a slot, it never blocks and never enters the kernel. If the ring is full, the message
+* is dropped and counted. Until the logger is started, messages are written directly.
+*/
+class AsyncLog
+{
+    public:
+        /**
+        * get the logger of the process
+        * @return the logger
+        */
+        static AsyncLog& instance();
+
+        /**
+        * check whether messages of a level are logged
+        * @param level  one of LOG_LEVEL_...
+        * @return true if they are logged
+        */
+        static bool enabled( int level )
+        {
+            return level >= sLevel.load( std::memory_order_relaxed );
+        }
+
+        /**
+        * set the lowest level which is logged at run time
+        * @param level  one of LOG_LEVEL_...
+        */
+        static void setLevel( int level );
+
+        /**
+        * start the thread writing the messages
+        * @param intervalMs  how often the ring is emptied
+        * @return true if successful
+        */
+        bool start( unsigned int intervalMs = 10 );
+
+        /**
+        * write the remaining messages and stop the thread; messages logged while stopping are written, too
+        */
+        void stop();
+
+        /**
+        * log a message, unless its level is disabled at run time
+        * @param level  one of LOG_LEVEL_...
+        * @param format printf-style format
+        */
+        void log( int level, const char* format, ... ) __attribute__(( format( printf, 3, 4 ) ));
+
+        /**
+        * log a message which has been rate limited, unless its level is disabled at run time
+        * @param level      one of LOG_LEVEL_...
+        * @param suppressed number of messages suppressed before this one, 0 if none
+        * @param format     printf-style format
+        */
+        void logSuppressed( int level, unsigned int suppressed, const char* format, ... ) __attribute__(( format( printf, 4, 5 ) ));
+
+    private:
+        /**
+        * slot of the ring; the sequence number tells producer and writer whose turn it is
+        */
+        struct Slot
+        {
+            std::atomic<uint64_t>  seq;
+            unsigned int           length;
+            char                   text[ ASYNC_LOG_MSG_SIZE ];
+        };
+
+        /**
+        * constructor
+        */
+        explicit AsyncLog();
+
+        /**
+        * destructor
+        */
+        virtual ~AsyncLog();
+
+        /**
+        * put a message into the ring
+        * @param suppressed  number of suppressed messages to be appended
+        * @param format      printf-style format
+        * @param args        arguments of the format
+        */
+        void push( unsigned int suppressed, const char* format, va_list args );
+
+        /**
+        * write all messages of the ring
+        * @return number of messages written
+        */
+        unsigned int drain();
+
+        /**
+        * main routine of the writer thread
+        * @param intervalMs  how often the ring is emptied
+        */
+        void run( unsigned int intervalMs );
+
+    private:
+        static std::atomic<int>    sLevel;
+
+        Slot                       mSlots[ ASYNC_LOG_NO_SLOTS ];
+        std::atomic<uint64_t>      mHead;           // next slot to be claimed by a producer
+        uint64_t                   mTail;           // next slot to be written, only used by the writer
+        std::atomic<bool>          mRunning;
+        std::atomic<unsigned int>  mNoPushing;      // producers between checking mRunning and publishing their slot
+        std::atomic<unsigned int>  mNoDropped;      // messages dropped because the ring was full
+        unsigned int               mNoReported;     // dropped messages already reported
+        std::thread                mThread;
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_ASYNC_LOG_HH */
@@ -0,0 +1,214 @@
+/* ===================================================
+ *  file:       CameraLanes.hh
+ * ---------------------------------------------------
+ *  purpose:	routing of images by camera into lanes
+ *              with their own encoders and statistics
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_CAMERA_LANES_HH
+#define _FRAMEWORK_CAMERA_LANES_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdint.h>
+#include <map>
+#include <set>
+#include <string>
+#include "FrameEncoder.hh"
+
+/* ====== DEFINITIONS ====== */
+#define FRAME_RESTART_STEP      100     // a sequence falling back by more steps is taken as a restart, whatever the simulation time
+
+namespace Framework
+{
+
+/**
+* check whether a sequence number falling back marks a restart of the simulation rather than an
+* image or frame arriving late: it does if the simulation time has been reset to the start of the
+* run as well, or if the sequence falls back by more than FRAME_RESTART_STEP steps
+* @param seq            sequence number received, smaller than the last one
+* @param last           latest sequence number received before
+* @param step           distance of two consecutive sequence numbers
+* @param simTime        simulation time received
+* @param lastSimTime    simulation time received with the latest sequence number
+* @param startSimTime   simulation time the run has been seen starting at
+* @return true if the simulation has been restarted
+*/
+bool isSimRestart( uint32_t seq, uint32_t last, uint32_t step, double simTime, double lastSimTime, double startSimTime );
+
+/**
+* processing lane of a single camera
+*/
+class CameraLane
+{
+    public:
+        /**
+        * constructor
+        * @param cameraId   id of the camera
+        * @param outputDir  directory the images of the camera are written to
+        */
+        explicit CameraLane( uint16_t cameraId, const std::string & outputDir );
+
+        /**
+        * destructor, writes the pending frames
+        */
+        virtual ~CameraLane();
+
+        /**
+        * get the index of the next image of the camera within a simulation frame
+        * @param simFrame   simulation frame of the image
+        * @return index, starting at 1
+        */
+        int nextCounter( unsigned int simFrame );
+
+        /**
+        * account for an image of the camera in the sequence of its frames; images which are
+        * missing, duplicated or out of order are counted
+        * @param frameNo    frame number of the message carrying the image
+        * @param imageId    id (frame count) of the image, 0 if not provided by the producer
+        * @param simTime    simulation time of the message carrying the image
+        */
+        void track( uint32_t frameNo, uint32_t imageId, double simTime );
+
+    public:
+        uint16_t            cameraId;
+        std::string         outputDir;
+        EncoderPool         encoders;       // worker threads of this camera only
+        unsigned int        noFrames;       // number of frames handed to the encoders
+        unsigned int        noDropped;      // number of new frames dropped because all encoders were busy
+        uint64_t            noBytes;        // number of bytes copied out of the SHM
+        unsigned int        noReceived;     // number of images found in the SHM
+        unsigned int        noMissing;      // number of images which never showed up in the SHM (overwritten by the producer)
+        unsigned int        noDuplicate;    // number of images received more than once
+        unsigned int        noOutOfOrder;   // number of images older than one received before
+        unsigned int        noRestarts;     // number of restarts of the sequence (simulation restarted)
+        uint64_t            tFirst;         // time the first image was received                        @unit ns
+        uint64_t            tLast;          // time the last image was received                         @unit ns
+
+    private:
+        unsigned int        mLastSimFrame;
+        int                 mCounter;
+        uint32_t            mLastFrameNo;   // frame number of the latest image
+        uint32_t            mLastImageId;   // id of the latest image
+        uint32_t            mFrameStride;   // smallest step of the frame number between two images of the camera
+        double              mLastSimTime;   // simulation time of the latest image                      @unit s
+        double              mStartSimTime;  // simulation time of the first image since the (re)start   @unit s
+};
+
+/**
+* routes the images of the SHM to one lane per camera; a slow camera only fills
+* its own queue, and cameras without consumer are skipped before any copying
+*/
+class CameraRouter
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit CameraRouter();
+
+        /**
+        * destructor, stops and deletes all lanes
+        */
+        virtual ~CameraRouter();
+
+        /**
+        * configure the lanes which are yet to be created
+        * @param encode     routine encoding a frame
+        * @param noThreads  number of encoder threads per camera
+        * @param queueDepth number of frames which may wait for an encoder, per camera
+        * @param outputDir  root directory of the per-camera directories
+        */
+        void configure( EncoderPool::EncodeFunc encode, unsigned int noThreads, unsigned int queueDepth, const std::string & outputDir );
+
+        /**
+        * set the behaviour of the lanes which are yet to be created when their encoders fall behind
+        * @param policy     one of BACKPRESSURE_...
+        * @param memoryCap  number of bytes which may be held by the frames of all lanes, 0 = unlimited
+        */
+        void setBackpressure( int policy, size_t memoryCap );
+
+        /**
+        * restrict the encoders of the lanes which are yet to be created to a set of CPUs
+        * @param cpus   the CPUs
+        */
+        void setAffinity( const cpu_set_t & cpus );
+
+        /**
+        * let the lanes which are yet to be created take the memory of their frames from a budget
+        * shared with other routers; the memory cap given to setBackpressure() is ignored then
+        * @param budget     the shared budget, 0 = a budget of this router
+        */
+        void setBudget( MemoryBudget* budget );
+
+        /**
+        * let the lanes which are yet to be created be encoded by workers shared with other lanes
+        * and routers instead of threads of their own; the number of threads per camera given to
+        * configure() then limits the number of images of a camera being encoded at the same time.
+        * The workers are owned by the caller, who has to stop them before destroying the router.
+        * @param workers    the shared workers, 0 = threads of each lane
+        */
+        void setWorkers( EncoderWorkers* workers );
+
+        /**
+        * add a camera to the consumed cameras; as long as none is added, all cameras are consumed
+        * @param cameraId   id of the camera
+        */
+        void addCamera( uint16_t cameraId );
+
+        /**
+        * get the lane of a camera, create it on first use
+        * @param cameraId   id of the camera
+        * @return pointer to the lane or 0 if the camera has no consumer
+        */
+        CameraLane* getLane( uint16_t cameraId );
+
+        /**
+        * get a frame of a lane; unless the policy is BACKPRESSURE_BLOCK, this does not wait, so a
+        * slow camera cannot hold up the others
+        * @param lane       the lane
+        * @param dataSize   number of bytes which are to be copied into the frame
+        * @return pointer to the frame or 0 if the frame has to be dropped
+        */
+        ImageFrame* acquire( CameraLane* lane, size_t dataSize );
+
+        /**
+        * hand a filled frame to the encoders of its lane
+        * @param lane       the lane
+        * @param frame      the frame
+        */
+        void submit( CameraLane* lane, ImageFrame* frame );
+
+        /**
+        * write the pending frames and stop the encoders of all lanes; the statistics remain available
+        */
+        void stop();
+
+        /**
+        * print the statistics of all lanes
+        * @param label  label printed in front of the numbers
+        * @param reset  reset the timing statistics after printing
+        */
+        void printStats( const char* label, bool reset = false );
+
+    private:
+        EncoderPool::EncodeFunc             mEncode;
+        unsigned int                        mNoThreads;
+        unsigned int                        mQueueDepth;
+        std::string                         mOutputDir;
+        int                                 mPolicy;        // backpressure policy of the lanes
+        MemoryBudget                        mBudget;        // memory cap shared by the lanes
+        MemoryBudget*                       mSharedBudget;  // memory cap shared with other routers, 0 = none
+        EncoderWorkers*                     mWorkers;       // encoders shared with other routers, 0 = threads of each lane
+        cpu_set_t                           mCpus;          // CPUs of the encoders
+        bool                                mHasCpus;
+        std::set<uint16_t>                  mSelected;      // consumed cameras, empty = all
+        std::map<uint16_t, CameraLane*>     mLanes;
+        std::map<uint16_t, unsigned int>    mSkipped;       // images of cameras without consumer
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_CAMERA_LANES_HH */
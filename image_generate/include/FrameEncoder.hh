@@ -0,0 +1,377 @@
+/* ===================================================
+ *  file:       FrameEncoder.hh
+ * ---------------------------------------------------
+ *  purpose:	pool of image frames copied out of shared
+ *              memory and threads which encode them
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_FRAME_ENCODER_HH
+#define _FRAMEWORK_FRAME_ENCODER_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <stdint.h>
+#include <sched.h>
+#include <atomic>
+#include <deque>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "viRDBIcd.h"
+#include "ShmNotify.hh"
+
+/**
+* number of frames which may be spilled at the same time: one is written to disk
+* by the spill thread while the reader copies the next one
+*/
+#define ENCODER_POOL_SPILL_FRAMES 2
+
+namespace Framework
+{
+
+class EncoderWorkers;
+
+/**
+* what happens to a new frame when the encoders fall behind, i.e. no frame is free or the memory cap is reached
+*/
+enum BackpressurePolicy
+{
+    BACKPRESSURE_DROP_NEWEST = 0,   // drop the new frame, the reader never waits (default)
+    BACKPRESSURE_BLOCK,             // the reader waits for a free frame; lossless, but holds the SHM buffer
+    BACKPRESSURE_DROP_OLDEST,       // replace the oldest frame waiting for an encoder (live monitoring)
+    BACKPRESSURE_KEEP_LATEST,       // only the latest frame of the camera waits for an encoder (preview)
+    BACKPRESSURE_SPILL              // copy the new frame aside and let a thread write it to disk; it is encoded once
+                                    // the encoders are idle. The reader only waits when the disk falls behind, too.
+};
+
+/**
+* upper limit of the memory held by frames waiting for or being encoded, shared by several pools
+*/
+class MemoryBudget
+{
+    public:
+        /**
+        * constructor
+        * @param limit  number of bytes which may be held, 0 = unlimited
+        */
+        explicit MemoryBudget( size_t limit = 0 );
+
+        /**
+        * set the limit
+        * @param limit  number of bytes which may be held, 0 = unlimited
+        */
+        void setLimit( size_t limit );
+
+        /**
+        * take a number of bytes from the budget
+        * @param size   number of bytes
+        * @return true if the bytes fit into the budget
+        */
+        bool reserve( size_t size );
+
+        /**
+        * give back bytes taken by reserve()
+        * @param size   number of bytes
+        */
+        void release( size_t size );
+
+    private:
+        size_t                  mLimit;
+        std::atomic<size_t>     mUsed;
+};
+
+/**
+* an image which has been copied out of shared memory and waits for encoding
+*/
+struct ImageFrame
+{
+    double       simTime;       /**< simulation time of the message carrying the image        */
+    unsigned int simFrame;      /**< simulation frame of the message carrying the image       */
+    int          counter;       /**< index of the image within the message                    */
+    RDB_IMAGE_t  info;          /**< image header as received                                 */
+    char*        data;          /**< pooled copy of the image data, converted for encoding    */
+    bool         pointCloud;    /**< data holds the points back-projected from a depth image  */
+    const char*  outputDir;     /**< directory the frame is written to                        */
+    size_t       dataSize;      /**< number of valid bytes in data                            */
+    size_t       capacity;      /**< allocated size of data                                   */
+    uint64_t     tReady;        /**< time the producer handed over the SHM buffer, 0 if unknown @unit ns */
+    uint64_t     tSubmit;       /**< time the frame was handed to the encoders         @unit ns */
+    uint64_t     tStart;        /**< time an encoder started working on the frame      @unit ns */
+};
+
+/**
+* bounded pool of image frames plus the threads which encode them; the number of
+* frames is fixed, and the backpressure policy decides what acquire() does when
+* the encoders fall behind
+*/
+class EncoderPool
+{
+    public:
+        /**
+        * routine which encodes (and writes) a single frame; called from the worker threads
+        */
+        typedef void ( *EncodeFunc )( ImageFrame* frame );
+
+        /**
+        * constructor
+        */
+        explicit EncoderPool();
+
+        /**
+        * destructor, stops the workers
+        */
+        virtual ~EncoderPool();
+
+        /**
+        * start the worker threads
+        * @param encode     routine to be called for each frame
+        * @param noThreads  number of worker threads
+        * @param queueDepth number of frames which may wait for a worker
+        * @return true if successful
+        */
+        bool start( EncodeFunc encode, unsigned int noThreads, unsigned int queueDepth );
+
+        /**
+        * set the behaviour when the encoders fall behind; to be called before start()
+        * @param policy     one of BACKPRESSURE_...
+        * @param budget     memory budget of the frames, shared with other pools; 0 = unlimited
+        * @param spillDir   directory receiving spilled frames (BACKPRESSURE_SPILL only)
+        */
+        void setBackpressure( int policy, MemoryBudget* budget = 0, const std::string & spillDir = "" );
+
+        /**
+        * restrict the workers to a set of CPUs; to be called before start(). Workers never keep
+        * a real-time policy inherited from the thread calling start().
+        * @param cpus   the CPUs, 0 = those of the thread calling start()
+        */
+        void setAffinity( const cpu_set_t* cpus );
+
+        /**
+        * let the frames be encoded by workers shared with other pools instead of threads of
+        * this pool; to be called before start(). The number of threads given to start() then
+        * only limits the number of frames of this pool being encoded at the same time.
+        * @param workers    the shared workers, 0 = threads of this pool
+        */
+        void setWorkers( EncoderWorkers* workers );
+
+        /**
+        * encode all pending frames and stop the worker threads
+        */
+        void stop();
+
+        /**
+        * get an unused frame with room for a given amount of data, applying the backpressure policy
+        * @param dataSize   number of bytes which are to be copied into the frame
+        * @return pointer to the frame or 0 if the pool has been stopped or the new frame is to be dropped
+        */
+        ImageFrame* acquire( size_t dataSize );
+
+        /**
+        * give back an acquired frame without encoding it
+        * @param frame  the frame
+        */
+        void release( ImageFrame* frame );
+
+        /**
+        * hand a filled frame to the workers
+        * @param frame  the frame
+        */
+        void submit( ImageFrame* frame );
+
+        /**
+        * print the statistics of the workers
+        * @param label  label printed in front of the numbers
+        * @param reset  reset after printing
+        */
+        void printStats( const char* label, bool reset = false );
+
+        /**
+        * encode a single pending frame; called by the shared workers
+        * @return true if a frame has been encoded, false if none was pending or the pool
+        *         already has as many frames being encoded as it may have
+        */
+        bool encodeOne();
+
+    private:
+        /**
+        * take a frame which may be filled; called with the mutex held
+        * @param dataSize   number of bytes which are to be copied into the frame
+        * @return pointer to the frame or 0 if none is available under the policy
+        */
+        ImageFrame* take( size_t dataSize );
+
+        /**
+        * make sure a frame has room for a given amount of data
+        * @param frame      the frame
+        * @param dataSize   number of bytes which are to be copied into the frame
+        * @return true if successful
+        */
+        static bool reserveData( ImageFrame* frame, size_t dataSize );
+
+        /**
+        * check whether a frame is one of the spill frames
+        * @param frame  the frame
+        * @return true if the frame is a spill frame
+        */
+        bool isSpillFrame( const ImageFrame* frame ) const;
+
+        /**
+        * write a spill frame to disk, queue it for encoding and give the spill frame back
+        * @param frame  the spill frame
+        */
+        void spill( ImageFrame* frame );
+
+        /**
+        * main routine of the spill thread
+        */
+        void runSpill();
+
+        /**
+        * read the oldest spilled frame back and encode it; called with the mutex held, releases it meanwhile
+        * @param lock   the held lock
+        */
+        void unspill( std::unique_lock<std::mutex> & lock );
+
+        /**
+        * encode the oldest pending frame; called with the mutex held, releases it meanwhile
+        * @param lock   the held lock
+        * @return true if a frame has been encoded, false if none was pending or the limit of shared workers is reached
+        */
+        bool encodeNext( std::unique_lock<std::mutex> & lock );
+
+        /**
+        * main routine of a worker thread
+        */
+        void run();
+
+    private:
+        EncodeFunc                 mEncode;
+        bool                       mStop;
+        std::vector<ImageFrame>    mFrames;         // all frames of the pool
+        std::vector<ImageFrame*>   mFree;           // frames which may be acquired
+        std::deque<ImageFrame*>    mQueue;          // frames waiting for a worker
+        std::vector<std::thread>   mThreads;
+        std::mutex                 mMutex;
+        std::condition_variable    mFreeCond;
+        std::condition_variable    mQueueCond;
+        TimingStats                mQueueStats;     // time between submit and start of encoding
+        TimingStats                mEncodeStats;    // time spent encoding and writing
+        int                        mPolicy;         // one of BACKPRESSURE_...
+        MemoryBudget*              mBudget;         // shared limit of the memory held by frames, 0 = none
+        std::string                mSpillDir;
+        std::vector<ImageFrame>    mSpillFrames;    // frames handed out while all others are in use (BACKPRESSURE_SPILL)
+        std::vector<ImageFrame*>   mSpillFree;      // spill frames which may be acquired
+        std::deque<ImageFrame*>    mSpillQueue;     // spill frames waiting to be written to disk
+        std::thread                mSpillThread;    // writes the spill frames, so that the reader does not wait for the disk
+        std::condition_variable    mSpillCond;
+        bool                       mSpillStop;      // the spill thread is to terminate once its queue is empty
+        std::deque<std::string>    mSpilled;        // spilled frames waiting for an encoder, oldest first
+        const char*                mSpillOutputDir; // output directory of the spilled frames
+        unsigned int               mNoSpillFiles;   // number of spill files written so far
+        unsigned int               mNoReplaced;     // frames replaced by newer ones before being encoded
+        unsigned int               mNoSpilled;      // frames written to disk because all frames were in use
+        unsigned int               mNoUnspilled;    // spilled frames which have been encoded
+        unsigned int               mNoBlocked;      // number of times the reader waited for a frame (or a spill frame)
+        TimingStats                mBlockStats;     // time the reader waited for a frame
+        cpu_set_t                  mCpus;           // CPUs of the workers
+        bool                       mHasCpus;
+        EncoderWorkers*            mWorkers;        // workers shared with other pools, 0 = threads of this pool
+        unsigned int               mNoActive;       // frames being encoded right now
+        unsigned int               mMaxActive;      // frames which may be encoded at the same time by shared workers
+};
+
+/**
+* threads encoding the frames of several pools, e.g. of all cameras of several SHM segments;
+* each worker serves its own share of the pools first and steals frames from the other
+* pools when its own ones are idle, so that the CPUs are balanced across the cameras
+*/
+class EncoderWorkers
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit EncoderWorkers();
+
+        /**
+        * destructor, stops the workers
+        */
+        virtual ~EncoderWorkers();
+
+        /**
+        * restrict the workers to a set of CPUs; to be called before start(). Workers never keep
+        * a real-time policy inherited from the thread calling start().
+        * @param cpus   the CPUs, 0 = those of the thread calling start()
+        */
+        void setAffinity( const cpu_set_t* cpus );
+
+        /**
+        * start the worker threads
+        * @param noThreads  number of worker threads
+        * @return true if successful
+        */
+        bool start( unsigned int noThreads );
+
+        /**
+        * encode the frames pending in all pools and stop the worker threads; the pools must
+        * not be destroyed before the workers are stopped
+        */
+        void stop();
+
+        /**
+        * check whether the workers are running
+        * @return true if running
+        */
+        bool isRunning() const;
+
+        /**
+        * add a pool to the pools served by the workers; pools are never removed
+        * @param pool   the pool
+        * @return true if successful
+        */
+        bool attach( EncoderPool* pool );
+
+        /**
+        * wake up a worker after a frame has been queued in one of the pools
+        */
+        void notify();
+
+        /**
+        * print the statistics of the workers
+        * @param label  label printed in front of the numbers
+        */
+        void printStats( const char* label );
+
+    private:
+        /**
+        * main routine of a worker thread
+        * @param index  index of the worker
+        */
+        void run( unsigned int index );
+
+    private:
+        static const unsigned int  MAX_POOLS = 256;
+
+        EncoderPool*               mPools[ MAX_POOLS ];
+        std::atomic<unsigned int>  mNoPools;
+        unsigned int               mNoThreads;
+        std::vector<std::thread>   mThreads;
+        std::atomic<bool>          mStop;
+        std::atomic<uint64_t>      mSeq;            // incremented whenever a frame has been queued
+        std::atomic<unsigned int>  mNoSleeping;     // number of workers waiting for a frame
+        std::mutex                 mMutex;
+        std::condition_variable    mCond;
+        std::atomic<unsigned int>  mNoEncoded;      // frames encoded by all workers
+        std::atomic<unsigned int>  mNoStolen;       // frames encoded by a worker not in charge of their pool
+        cpu_set_t                  mCpus;           // CPUs of the workers
+        bool                       mHasCpus;
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_FRAME_ENCODER_HH */
@@ -0,0 +1,239 @@
+/* ===================================================
+ *  file:       FrameRecorder.hh
+ * ---------------------------------------------------
+ *  purpose:	append-only recording of raw RDB messages
+ *              into memory mapped segment files and
+ *              reading of such recordings
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_FRAME_RECORDER_HH
+#define _FRAMEWORK_FRAME_RECORDER_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include "viRDBIcd.h"
+
+/* ====== DEFINITIONS ====== */
+#define RDB_REC_MAGIC_NO        0x43455252      /**< "RREC" at the start of segment and index files             */
+#define RDB_REC_VERSION         0x0001          /**< version of the recording layout                            */
+#define RDB_REC_NO_CAMERA       0xffff          /**< camera id of index records of messages without image       */
+
+namespace Framework
+{
+
+/**
+* header at the start of each segment file <name>_<segmentNo>.rdbrec; it is
+* followed by the raw RDB messages, each one as found in the SHM
+*/
+typedef struct
+{
+    uint32_t  magicNo;          /**< RDB_REC_MAGIC_NO                                                   */
+    uint16_t  version;          /**< RDB_REC_VERSION                                                    */
+    uint16_t  headerSize;       /**< size of this header                                       @unit byte */
+    uint32_t  segmentNo;        /**< number of the segment within the recording                         */
+    uint32_t  spare0;           /**< just a spare                                                       */
+    uint64_t  dataSize;         /**< number of bytes of messages following the header, set on closing   */
+} RDB_REC_SEGMENT_HDR_t;
+
+/**
+* header at the start of the index file <name>.rdbidx; it is followed by
+* fixed size records, one per image and one per message without image
+*/
+typedef struct
+{
+    uint32_t  magicNo;          /**< RDB_REC_MAGIC_NO                                                   */
+    uint16_t  version;          /**< RDB_REC_VERSION                                                    */
+    uint16_t  headerSize;       /**< size of this header                                       @unit byte */
+    uint32_t  recordSize;       /**< size of an index record                                   @unit byte */
+    uint32_t  spare0;           /**< just a spare                                                       */
+} RDB_REC_INDEX_HDR_t;
+
+/**
+* record of the index file
+*/
+typedef struct
+{
+    uint32_t  frameNo;          /**< frame number of the message                                        */
+    uint16_t  cameraId;         /**< camera of the image, RDB_REC_NO_CAMERA for messages without image */
+    uint16_t  segmentNo;        /**< segment holding the message                                        */
+    double    simTime;          /**< simulation time of the message                           @unit s   */
+    uint64_t  msgOffset;        /**< offset of the message within the segment file            @unit byte */
+    uint32_t  msgSize;          /**< size of the message including its header                 @unit byte */
+    uint32_t  imgOffset;        /**< offset of the RDB_IMAGE_t within the message, 0 if none  @unit byte */
+} RDB_REC_INDEX_t;
+
+/**
+* recorder appending raw RDB messages to preallocated, memory mapped segment
+* files; recording a message costs a single memcpy plus a few index records
+*/
+class FrameRecorder
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit FrameRecorder();
+
+        /**
+        * destructor, closes the recording
+        */
+        virtual ~FrameRecorder();
+
+        /**
+        * start a new recording
+        * @param name           base name of the files; segments are <name>_<n>.rdbrec, the index is <name>.rdbidx
+        * @param segmentSize    size to which each segment file is preallocated
+        * @return true if successful
+        */
+        bool open( const std::string & name, size_t segmentSize = ( size_t ) 1 << 30 );
+
+        /**
+        * finish the recording, truncating the last segment to its used size
+        */
+        void close();
+
+        /**
+        * check whether a recording is open
+        * @return true if open
+        */
+        bool isOpen() const;
+
+        /**
+        * append a message
+        * @param msg    the message as found in the SHM
+        * @return true if successful; on failure, the recording is closed
+        */
+        bool record( const RDB_MSG_t* msg );
+
+        /**
+        * print the statistics of the recording
+        * @param label  label printed in front of the numbers
+        */
+        void printStats( const char* label ) const;
+
+    private:
+        /**
+        * finish the current segment and start the next one
+        * @param minSize    minimum size of the new segment
+        * @return true if successful
+        */
+        bool nextSegment( size_t minSize );
+
+        /**
+        * finish the current segment
+        */
+        void closeSegment();
+
+        /**
+        * append a record to the index
+        * @return true if successful
+        */
+        bool addIndex( const RDB_MSG_t* msg, uint64_t msgOffset, uint32_t msgSize, uint16_t cameraId, uint32_t imgOffset );
+
+    private:
+        std::string  mName;
+        size_t       mSegmentSize;      // preallocated size of a segment
+        FILE*        mIndex;            // index file
+        int          mSegmentFd;        // current segment file
+        char*        mSegment;          // mapping of the current segment
+        size_t       mMappedSize;       // size of the mapping
+        size_t       mUsed;             // bytes used in the current segment, including its header
+        unsigned int mSegmentNo;        // number of the current segment
+        uint64_t     mNoMessages;
+        uint64_t     mNoImages;
+        uint64_t     mNoBytes;
+};
+
+/**
+* reader of a recording written by FrameRecorder; the segments are mapped
+* read-only, so the messages are handed out without copying
+*/
+class RecordingReader
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit RecordingReader();
+
+        /**
+        * destructor, closes the recording
+        */
+        virtual ~RecordingReader();
+
+        /**
+        * open a recording
+        * @param name   base name of the files, as given to FrameRecorder::open()
+        * @return true if successful
+        */
+        bool open( const std::string & name );
+
+        /**
+        * close the recording
+        */
+        void close();
+
+        /**
+        * check whether a recording is open
+        * @return true if open
+        */
+        bool isOpen() const;
+
+        /**
+        * get the messages of the next frame, i.e. the following messages carrying the same frame number
+        * @param msgs   receives pointers to the messages, valid until the recording is closed
+        * @return false at the end of the recording
+        */
+        bool nextFrame( std::vector<const RDB_MSG_t*> & msgs );
+
+        /**
+        * restart at the first message
+        */
+        void rewind();
+
+        /**
+        * get the number of messages of the recording
+        * @return number of messages
+        */
+        size_t getNoMessages() const;
+
+        /**
+        * get the size of the largest frame, i.e. the SHM buffer size needed to replay the recording
+        * @return size of all messages of the frame                                       @unit byte
+        */
+        size_t getMaxFrameSize() const;
+
+        /**
+        * get the frame number of the first and the last message
+        * @param first  frame number of the first message
+        * @param last   frame number of the last message
+        */
+        void getFrameRange( uint32_t & first, uint32_t & last ) const;
+
+    private:
+        /**
+        * map a segment file and check its header
+        * @param segmentNo  number of the segment
+        * @return true if successful
+        */
+        bool mapSegment( unsigned int segmentNo );
+
+    private:
+        std::string                   mName;
+        std::vector<RDB_REC_INDEX_t>  mMessages;        // one index record per message
+        std::vector<char*>            mSegments;        // read-only mappings of the segments
+        std::vector<size_t>           mSegmentSizes;    // sizes of the mappings
+        size_t                        mNext;            // index of the next message
+        size_t                        mMaxFrameSize;
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_FRAME_RECORDER_HH */
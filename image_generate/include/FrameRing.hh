@@ -0,0 +1,203 @@
+/* ===================================================
+ *  file:       FrameRing.hh
+ * ---------------------------------------------------
+ *  purpose:	ring of decoded frames in POSIX shared
+ *              memory, published by the reader for any
+ *              number of local consumer processes
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_FRAME_RING_HH
+#define _FRAMEWORK_FRAME_RING_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include "viRDBIcd.h"
+
+/* ====== DEFINITIONS ====== */
+#define FRAME_RING_MAGIC_NO     0x46524e47      // "FRNG", set once the ring is initialized
+#define FRAME_RING_VERSION      1               // version of the layout
+#define FRAME_RING_ALIGN        64              // alignment of the slots and of their data @unit byte
+
+namespace Framework
+{
+
+/**
+* header of the ring, at the start of the shared memory object; the slots follow at hdrSize
+*/
+typedef struct
+{
+    uint32_t  magicNo;      /**< FRAME_RING_MAGIC_NO while the producer runs, 0 once it has closed the ring */
+    uint16_t  version;      /**< FRAME_RING_VERSION                                                        */
+    uint16_t  hdrSize;      /**< size of this header, offset of the first slot                   @unit byte */
+    uint32_t  noSlots;      /**< number of slots                                                           */
+    uint32_t  slotSize;     /**< distance of two slots, slot header included                      @unit byte */
+    uint32_t  maxDataSize;  /**< room for the data of a frame in a slot                           @unit byte */
+    uint32_t  pid;          /**< process id of the producer                                                */
+    uint64_t  noPublished;  /**< number of frames published; frame n is held by slot n % noSlots           */
+    uint64_t  spare[4];     /**< just spares                                                               */
+} FRAME_RING_HDR_t;
+
+/**
+* header of a slot, followed by the data of the frame at FRAME_RING_ALIGN; the slot is
+* guarded by a sequence lock, so readers may use the data in place as long as check()
+* confirms afterwards that it has not been overwritten meanwhile
+*/
+typedef struct
+{
+    uint32_t     seq;           /**< sequence lock, odd while the producer writes the slot                  */
+    uint32_t     dataSize;      /**< number of valid bytes of data                               @unit byte */
+    uint64_t     frameNo;       /**< index of the frame in the order of publishing                          */
+    double       simTime;       /**< simulation time of the message carrying the image           @unit s    */
+    uint32_t     simFrame;      /**< simulation frame of the message carrying the image                     */
+    uint32_t     shmKey;        /**< key of the RDB SHM segment the image came from                         */
+    uint16_t     width;         /**< width of the image                                          @unit pixel */
+    uint16_t     height;        /**< height of the image                                         @unit pixel */
+    uint8_t      channels;      /**< number of channels of a pixel (3 for points)                           */
+    uint8_t      channelType;   /**< type of the channels, PIXEL_CHANNEL_...                                */
+    uint8_t      orientation;   /**< orientation the image has been written in, IMAGE_ORIENT_...           */
+    uint8_t      pointCloud;    /**< 0 = image, 1 = points x, y, z interleaved, 2 = points as x, y, z planes */
+    uint64_t     tReady;        /**< time the IG handed over the SHM buffer, 0 if unknown        @unit ns   */
+    uint64_t     tPublish;      /**< time the frame has been published                           @unit ns   */
+    RDB_IMAGE_t  info;          /**< image header as received from the IG                                   */
+} FRAME_RING_SLOT_t;
+
+/**
+* the ring of decoded frames; the producer creates it and is its only writer, consumers open it
+* read-only. Channels of images are in the order expected by OpenCV (BGR), as written to disk.
+*/
+class FrameRing
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit FrameRing();
+
+        /**
+        * destructor, closes the ring
+        */
+        virtual ~FrameRing();
+
+        /**
+        * create the ring (producer side); a ring left behind under the same name is replaced,
+        * consumers still mapping it see it closed
+        * @param name           name of the POSIX shared memory object
+        * @param noSlots        number of slots
+        * @param maxDataSize    room for the data of a frame
+        * @return true if successful
+        */
+        bool create( const std::string & name, unsigned int noSlots, size_t maxDataSize );
+
+        /**
+        * open an existing ring (consumer side)
+        * @param name   name of the POSIX shared memory object
+        * @return true if successful
+        */
+        bool open( const std::string & name );
+
+        /**
+        * close the ring; the producer marks it closed and removes the name
+        */
+        void close();
+
+        /**
+        * check whether the ring is open
+        * @return true if open
+        */
+        bool isOpen() const;
+
+        /**
+        * check whether the producer of an opened ring still runs; besides the ring being marked
+        * closed, the producer process is checked for existence every 100 ms. The process id is
+        * only meaningful if producer and consumer share the PID namespace.
+        * @return true if it does, false if the ring is to be opened again
+        */
+        bool isAlive() const;
+
+        /**
+        * start writing the next slot (producer side)
+        * @param dataSize   number of bytes of the frame
+        * @return header of the slot or 0 if the ring is not open or the frame is too large
+        */
+        FRAME_RING_SLOT_t* beginWrite( size_t dataSize );
+
+        /**
+        * publish the slot obtained by beginWrite() (producer side)
+        * @param slot   the slot
+        */
+        void endWrite( FRAME_RING_SLOT_t* slot );
+
+        /**
+        * get the number of frames published so far
+        * @return number of frames; the latest one is frame getNoPublished() - 1
+        */
+        uint64_t getNoPublished() const;
+
+        /**
+        * get the slot of a frame for reading in place (consumer side)
+        * @param frameNo    index of the frame
+        * @param version    receives the state of the sequence lock, to be passed to check()
+        * @return header of the slot or 0 if the frame is being written or has been overwritten
+        */
+        const FRAME_RING_SLOT_t* peek( uint64_t frameNo, uint32_t & version ) const;
+
+        /**
+        * check whether a slot still holds the frame it held at peek()
+        * @param slot       header of the slot
+        * @param version    state of the sequence lock returned by peek()
+        * @return true if everything read from the slot in between is valid
+        */
+        bool check( const FRAME_RING_SLOT_t* slot, uint32_t version ) const;
+
+        /**
+        * get the data of a slot
+        * @param slot   header of the slot
+        * @return start of the data
+        */
+        static char* getData( FRAME_RING_SLOT_t* slot );
+        static const char* getData( const FRAME_RING_SLOT_t* slot );
+
+        /**
+        * get the number of slots
+        * @return number of slots, 0 if not open
+        */
+        unsigned int getNoSlots() const;
+
+        /**
+        * get the number of frames which have not been published since they did not fit into a slot
+        * @return number of frames
+        */
+        unsigned int getNoTooLarge() const;
+
+    private:
+        /**
+        * get the header of a slot
+        * @param index  index of the slot
+        * @return header of the slot
+        */
+        FRAME_RING_SLOT_t* getSlot( uint64_t index ) const;
+
+        /**
+        * check whether a process exists
+        * @param pid    process id
+        * @return true if it exists
+        */
+        static bool producerExists( uint32_t pid );
+
+    private:
+        FRAME_RING_HDR_t*   mHdr;           // the mapped ring
+        size_t              mSize;          // size of the mapping
+        bool                mOwner;         // created by this process?
+        std::string         mName;          // name of the shared memory object
+        unsigned int        mNoTooLarge;    // frames not published since they did not fit
+        mutable uint64_t    mTPidCheck;     // time the producer process has been checked for existence last   @unit ns
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_FRAME_RING_HH */
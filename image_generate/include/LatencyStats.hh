@@ -0,0 +1,158 @@
+/* ===================================================
+ *  file:       LatencyStats.hh
+ * ---------------------------------------------------
+ *  purpose:	latency histograms of the processing
+ *              stages of a frame, filled lock-free
+ *              by the threads of the reader
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_LATENCY_STATS_HH
+#define _FRAMEWORK_LATENCY_STATS_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdint.h>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Framework
+{
+
+/**
+* processing stages of a frame, from the producer handing over the SHM buffer
+* to the file being written
+*/
+enum LatencyStage
+{
+    LATENCY_DETECT = 0,     // buffer handed over by the producer (doorbell or last empty probe) until it is found
+    LATENCY_LOCK,           // buffer found until it is locked
+    LATENCY_COPY,           // buffer locked until the image starts leaving the SHM (earlier packages, frame acquisition)
+    LATENCY_CONVERT,        // copy out of the SHM including conversion (or back-projection), done in one pass
+    LATENCY_QUEUE,          // waiting for an encoder thread
+    LATENCY_ENCODE,         // encoding into PNG / TIFF in memory
+    LATENCY_WRITE,          // writing the file
+    LATENCY_TOTAL,          // buffer handed over until the file is written
+    LATENCY_NO_STAGES
+};
+
+/**
+* histogram of durations with logarithmic buckets, 16 per power of two (resolution
+* better than 7 %); it has a single writer, so counting needs no atomic read-modify-write
+*/
+class LatencyHistogram
+{
+    public:
+        enum { NO_SUB_BUCKETS = 16, NO_BUCKETS = 61 * NO_SUB_BUCKETS };
+
+        /**
+        * constructor
+        */
+        explicit LatencyHistogram();
+
+        /**
+        * add a sample; only to be called by the owning thread
+        * @param durationNs  the duration
+        */
+        void add( uint64_t durationNs );
+
+        /**
+        * get the count of a bucket; may be called by any thread
+        * @param index  index of the bucket
+        * @return number of samples in the bucket
+        */
+        uint64_t getCount( unsigned int index ) const;
+
+        /**
+        * get the largest sample; may be called by any thread
+        * @return largest duration                                                    @unit ns
+        */
+        uint64_t getMax() const;
+
+        /**
+        * get the bucket of a duration
+        * @param durationNs  the duration
+        * @return index of the bucket
+        */
+        static unsigned int bucket( uint64_t durationNs );
+
+        /**
+        * get the largest duration counted in a bucket
+        * @param index  index of the bucket
+        * @return upper bound of the bucket                                           @unit ns
+        */
+        static uint64_t upperBound( unsigned int index );
+
+    private:
+        std::atomic<uint64_t>   mCounts[ NO_BUCKETS ];
+        std::atomic<uint64_t>   mMax;
+};
+
+/**
+* latency statistics of all stages; every thread adds its samples to histograms
+* of its own, which are only summed up for printing
+*/
+class LatencyStats
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit LatencyStats();
+
+        /**
+        * destructor
+        */
+        virtual ~LatencyStats();
+
+        /**
+        * add a sample of the calling thread
+        * @param stage       one of LATENCY_...
+        * @param durationNs  the duration
+        */
+        void add( int stage, uint64_t durationNs );
+
+        /**
+        * add the difference of two timestamps, if both are set and in order
+        * @param stage       one of LATENCY_...
+        * @param tStart      start of the stage, 0 if unknown
+        * @param tEnd        end of the stage, 0 if unknown
+        */
+        void add( int stage, uint64_t tStart, uint64_t tEnd );
+
+        /**
+        * print p50, p99 and max of all stages
+        * @param label       label printed in front of the numbers
+        * @param interval    only use the samples added since the last interval print; the maximum is then
+        *                    limited by its bucket, otherwise exact
+        */
+        void print( const char* label, bool interval = false );
+
+    private:
+        /**
+        * histograms of a single thread
+        */
+        struct ThreadHistograms
+        {
+            std::thread::id     threadId;
+            LatencyHistogram    stages[ LATENCY_NO_STAGES ];
+        };
+
+        /**
+        * get the histograms of the calling thread, create them on first use
+        * @return the histograms
+        */
+        ThreadHistograms* local();
+
+    private:
+        std::mutex                       mMutex;        // guards the list of threads, not the histograms
+        std::vector<ThreadHistograms*>   mThreads;
+        std::vector<uint64_t>            mPrinted;      // bucket counts of all stages at the last interval print
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_LATENCY_STATS_HH */
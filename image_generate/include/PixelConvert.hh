@@ -0,0 +1,109 @@
+/* ===================================================
+ *  file:       PixelConvert.hh
+ * ---------------------------------------------------
+ *  purpose:	conversion of RDB images into the pixel
+ *              layout written by the encoders
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_PIXEL_CONVERT_HH
+#define _FRAMEWORK_PIXEL_CONVERT_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Framework
+{
+
+/**
+* orientation of the converted image relative to the RDB image; RDB images
+* are stored bottom-up, so a vertical flip yields an upright image
+*/
+enum ImageOrientation
+{
+    IMAGE_ORIENT_NONE,              // keep the row order of the RDB image
+    IMAGE_ORIENT_FLIP_VERTICAL,     // mirror at the horizontal axis (default)
+    IMAGE_ORIENT_ROTATE_180,        // mirror at both axes
+    IMAGE_ORIENT_FLIP_HORIZONTAL    // mirror at the vertical axis
+};
+
+/**
+* type of a channel of a converted pixel
+*/
+enum PixelChannelType
+{
+    PIXEL_CHANNEL_U8,               // unsigned 8 bit
+    PIXEL_CHANNEL_U16,              // unsigned 16 bit
+    PIXEL_CHANNEL_F32               // 32 bit floating point
+};
+
+/**
+* routine converting a single row of pixels
+* @param src        first pixel of the source row
+* @param dst        first pixel of the destination row
+* @param width      number of pixels in the row
+* @param mirror     write the pixels in reverse order (only if the conversion mirrors by itself)
+*/
+typedef void ( *PixelRowFunc )( const uint8_t* src, uint8_t* dst, unsigned int width, bool mirror );
+
+/**
+* entry of the conversion table; colour images are converted to BGR(A) channel order,
+* half floats are widened to 32 bit and 24/32 bit depth values are normalized to [0, 1]
+*/
+typedef struct
+{
+    uint16_t      pixelFormat;      /**< source format, RDB_PIX_FORMAT_...                              */
+    uint8_t       pixelSize;        /**< size of a source pixel                               @unit bit */
+    uint8_t       channels;         /**< number of channels of a converted pixel                        */
+    uint8_t       channelType;      /**< type of the channels of a converted pixel, PIXEL_CHANNEL_...  */
+    bool          mirrors;          /**< the row routine writes mirrored rows by itself                */
+    const char*   name;             /**< name of the source format                                      */
+    PixelRowFunc  convertRow;       /**< row routine picked for the CPU                                 */
+} PIXEL_CONVERSION_t;
+
+/**
+* find the conversion of a source pixel format
+* @param pixelFormat    format of the RDB image, RDB_PIX_FORMAT_...
+* @param pixelSize      size of a pixel of the RDB image in bits
+* @return pointer to the table entry or 0 if the combination is not supported
+*/
+const PIXEL_CONVERSION_t* findPixelConversion( uint16_t pixelFormat, uint8_t pixelSize );
+
+/**
+* find the conversion of a source pixel format by its name
+* @param name   name of the format without prefix, e.g. "RGB8" or "depth32" (case is ignored)
+* @return pointer to the table entry or 0 if the format is not supported
+*/
+const PIXEL_CONVERSION_t* findPixelConversion( const char* name );
+
+/**
+* get the size of a converted pixel
+* @param conv   the conversion
+* @return size in bytes
+*/
+size_t convertedPixelSize( const PIXEL_CONVERSION_t* conv );
+
+/**
+* convert an RDB image and apply the orientation in the same pass; the source is
+* read exactly once, so it may reside in shared memory
+* @param conv        the conversion
+* @param src         first pixel of the source image
+* @param dst         destination of width * height * convertedPixelSize() bytes
+* @param width       width of the image in pixels
+* @param height      height of the image in pixels
+* @param orientation one of IMAGE_ORIENT_...
+*/
+void convertImage( const PIXEL_CONVERSION_t* conv, const void* src, void* dst, unsigned int width, unsigned int height, int orientation );
+
+/**
+* get the name of the SIMD variant used by the conversion kernels
+* @return name of the variant
+*/
+const char* pixelConvertIsa();
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_PIXEL_CONVERT_HH */
@@ -0,0 +1,113 @@
+/* ===================================================
+ *  file:       PointCloud.hh
+ * ---------------------------------------------------
+ *  purpose:	back-projection of RDB depth images into
+ *              point clouds and their output
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_POINT_CLOUD_HH
+#define _FRAMEWORK_POINT_CLOUD_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include "viRDBIcd.h"
+#include "PixelConvert.hh"
+
+namespace Framework
+{
+
+/**
+* layout of the exported point clouds
+*/
+enum PointCloudFormat
+{
+    POINT_CLOUD_OFF,        // depth images are written as images
+    POINT_CLOUD_PCD,        // PCD file, DATA binary, points as x y z
+    POINT_CLOUD_SOA         // raw floats: all x, then all y, then all z
+};
+
+/**
+* back-projection of depth images through the intrinsics of the camera which
+* rendered them; the points are given in camera coordinates, x along the image
+* columns, y along the rows (in the order in which they are stored) and z along
+* the viewing direction; pixels without depth (sky) yield NaN points
+*/
+class DepthProjector
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit DepthProjector();
+
+        /**
+        * destructor
+        */
+        virtual ~DepthProjector();
+
+        /**
+        * check whether images of a given format can be back-projected; DEPTH images
+        * hold the z-buffer, RED32F images are taken as metric depth
+        * @param pixelFormat    format of the RDB image, RDB_PIX_FORMAT_...
+        * @param pixelSize      size of a pixel of the RDB image in bits
+        * @return true if supported
+        */
+        static bool isDepthFormat( uint16_t pixelFormat, uint8_t pixelSize );
+
+        /**
+        * prepare the projection of an image; the per-column and per-row factors
+        * are only recomputed if the camera or the image dimensions change
+        * @param camera     the camera which rendered the image
+        * @param image      header of the depth image
+        * @return true if the image can be back-projected
+        */
+        bool setup( const RDB_CAMERA_t & camera, const RDB_IMAGE_t & image );
+
+        /**
+        * get the size of the buffer required by project()
+        * @return size in bytes
+        */
+        size_t getOutputSize() const;
+
+        /**
+        * back-project the image given to setup()
+        * @param src    first pixel of the depth image
+        * @param dst    destination of getOutputSize() bytes
+        * @param soa    write x, y and z planes instead of x y z triples
+        */
+        void project( const void* src, float* dst, bool soa );
+
+    private:
+        RDB_CAMERA_t               mCamera;         // camera the factors have been computed for
+        uint16_t                   mPixelFormat;
+        uint8_t                    mPixelSize;
+        unsigned int               mWidth;
+        unsigned int               mHeight;
+        const PIXEL_CONVERSION_t*  mDecode;         // conversion of a row into floats, 0 for DEPTH16
+        float                      mZbufA;          // z = A / ( B - d * C ) for z-buffer values d
+        float                      mZbufB;
+        float                      mZbufC;
+        std::vector<float>         mColFactor;      // ( u - principalX ) / focalX
+        std::vector<float>         mRowFactor;      // ( v - principalY ) / focalY
+        std::vector<float>         mDepthRow;       // decoded depth values of a row
+};
+
+/**
+* write a point cloud produced by DepthProjector::project()
+* @param fileName   name of the file
+* @param points     the points
+* @param width      width of the depth image
+* @param height     height of the depth image
+* @param soa        the points are given as x, y and z planes (raw file) instead of triples (PCD file)
+* @return true if successful
+*/
+bool writePointCloud( const char* fileName, const float* points, unsigned int width, unsigned int height, bool soa );
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_POINT_CLOUD_HH */
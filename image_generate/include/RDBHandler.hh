@@ -91,7 +91,7 @@ class RDBHandler
 
         /**
         * add a packet or series of packets to an RDB message
-        * @param  msg            pointer to the message that is to be extended / composed (0 for new message); may be altered!
+        * @param  msg            pointer to the message that is to be extended / composed (0 for new message, otherwise allocated with malloc()); may be altered!
         * @param  simTime        simulation time for which to compose the package
         * @param  simFrame       simulation frame for which to compose the package
         * @param  pkgId          id of the package that is to be added to the message 
@@ -512,10 +512,39 @@ class RDBHandler
         virtual ~RDBHandler();
         
         /**
-        * (re-) initialize the RDB message, i.e. internally held data
+        * (re-) initialize the RDB message, i.e. internally held data; the memory of the previous
+        * message is kept for composing the next one
         */
         void initMsg();
         
+        /**
+        * (re-) initialize the RDB message and compose it in a buffer provided by the caller; if the
+        * message outgrows the buffer, it is moved to memory held by the handler
+        * @param buffer   buffer in which to compose the message, 0 for memory held by the handler
+        * @param size     size of the buffer
+        */
+        void initMsg( void* buffer, size_t size );
+        
+        /**
+        * (re-) initialize the RDB message with a copy of a given message, e.g. for extending it
+        * @param msg      message that is to be copied, 0 for an empty message
+        * @return true if successful
+        */
+        bool setMsg( const RDB_MSG_t* msg );
+        
+        /**
+        * make room for a message of a given size, so that composing it does not move it
+        * @param size     total size of the message, header included
+        * @return true if successful
+        */
+        bool reserveMsg( size_t size );
+        
+        /**
+        * get the size of the memory available for the current message
+        * @return size of the memory in which the message is composed
+        */
+        size_t getMsgCapacity();
+        
         /**
         * add a packet or series of packets to an RDB message
         * @param  simTime        simulation time for which to compose the package
@@ -571,7 +600,8 @@ class RDBHandler
         void* getFirstEntry( unsigned int pkgId, unsigned int & noElements, bool extended );
 
         /**
-        * retrieve the pointer to the first entry header of a given type from the internally held message
+        * retrieve the pointer to the first entry header of a given type from the internally held message;
+        * the entries are looked up in an index instead of searching the message
         * @param  pkgId          id (i.e. type) of the entry that is to be retrieved 
         * @param  extended       true if an extended element is to be retrieved
         * @return pointer to first entry header of the requested entry type or 0 if none has been found.
@@ -675,7 +705,7 @@ class RDBHandler
         bool shmBufferHasFlags( unsigned int index, unsigned int mask );
         
         /**
-        * copy the current message to the shared memory, replacing existing data
+        * copy the current message to the shared memory, replacing existing data; the end of the data is marked
         * @param index  index of the buffer to which the message shall be copied
         * @param relocateBuffers  if true, buffer locations (i.e. offsets) will be adjusted to size of copied data; this requires buffers to be filled sequentially!
         * @return true if successful
@@ -683,7 +713,7 @@ class RDBHandler
         bool mapMsgToShm( unsigned int index, bool relocateBuffers = true );
         
         /**
-        * add a message to the shared memory, extending existing data
+        * add a message to the shared memory, extending existing data; the end of the data is marked
         * @param index  index of the buffer to which the message shall be copied
         * @param msg    pointer to the message that is to be transferred to SHM
         * @return true if successful
@@ -691,7 +721,8 @@ class RDBHandler
         bool addMsgToShm( unsigned int index, RDB_MSG_t* msg );
         
         /**
-        * get the usage of an SHM buffer
+        * get the usage of an SHM buffer from the count kept in the buffer info; builds defining
+        * RDB_HANDLER_CHECK_USED_SIZE verify the count against the messages of the buffer
         * @param index  index of the buffer which shall be queried
         * @return number of bytes occupied in the buffer
         */
@@ -705,6 +736,13 @@ class RDBHandler
         */
         bool shmBufferClear( unsigned int index, bool force = false );
         
+        /**
+        * empty the given SHM buffer without clearing its contents
+        * @param index  index of the buffer to which is to be emptied
+        * @return true if successful
+        */
+        bool shmBufferReset( unsigned int index );
+        
         /**
         * check if a given SHM buffer is locked
         * @param index  index of the buffer to which is to be checked
@@ -713,9 +751,10 @@ class RDBHandler
         bool shmBufferIsLocked( unsigned int index );
         
         /**
-        * lock a given SHM buffer 
+        * lock a given SHM buffer; the generation of the buffer contents becomes odd, as
+        * the holder of the lock may alter them
         * @param index  index of the buffer to which is to be locked
-        * @return true if buffer could be locked
+        * @return true if buffer could be locked, false if it is locked already
         */
         bool shmBufferLock( unsigned int index );
         
@@ -726,6 +765,72 @@ class RDBHandler
         */
         bool shmBufferRelease( unsigned int index );
         
+        /**
+        * hand a buffer locked with shmBufferLock() over to the readers, replacing the lock by the given flags
+        * @param index  index of the buffer
+        * @param flags  flags which are to be set, e.g. RDB_SHM_BUFFER_FLAG_TC
+        * @return true if successful
+        */
+        bool shmBufferHandOver( unsigned int index, unsigned int flags = RDB_SHM_BUFFER_FLAG_TC );
+        
+        /**
+        * start composing a message right in an SHM buffer instead of copying it there; the buffer
+        * has to be locked with shmBufferLock() before, it is released by committing or aborting the message
+        * @param index     index of the buffer in which the message is to be composed
+        * @param simTime   simulation time of the message
+        * @param simFrame  simulation frame of the message
+        * @param append    if true, the message is placed behind the messages the buffer holds, otherwise it replaces them
+        * @return header of the message or 0 if there is no room or a message is being composed already
+        */
+        RDB_MSG_HDR_t* shmMsgBegin( unsigned int index, const double & simTime, const unsigned int & simFrame, bool append = false );
+        
+        /**
+        * add a packet or series of packets to the message composed in SHM; the packages are cleared,
+        * their trailing data is left to the caller
+        * @param  pkgId          id of the package that is to be added to the message 
+        * @param  noElements     number of elements of given package ID type that are to be added
+        * @param  extended       true if an extended element is to be inserted
+        * @param  trailingData   size of trailing data of each element
+        * @param  entryHdr       if given, receives the header of the entry holding the packages
+        * @return pointer where to start inserting the data, otherwise 0 (e.g. if the buffer is full)
+        */
+        void* shmMsgAddPackage( unsigned int pkgId, unsigned int noElements = 1, bool extended = false, 
+                                size_t trailingData = 0, RDB_MSG_ENTRY_HDR_t** entryHdr = 0 );
+        
+        /**
+        * add a series of images of equal size to the message composed in SHM
+        * @param  noImages       number of images
+        * @param  imgSize        size of the image data of each image
+        * @return header of the first image with imgSize set, otherwise 0; see getImageData() and getNextImage()
+        */
+        RDB_IMAGE_t* shmMsgAddImages( unsigned int noImages, size_t imgSize );
+        
+        /**
+        * get the data trailing an image header
+        * @param  image          header of the image
+        * @return start of the image data
+        */
+        static void* getImageData( RDB_IMAGE_t* image );
+        
+        /**
+        * get the next image of an image package
+        * @param  image          header of the image, with imgSize set
+        * @return header of the next image
+        */
+        static RDB_IMAGE_t* getNextImage( RDB_IMAGE_t* image );
+        
+        /**
+        * make the message composed in SHM valid and hand the buffer over, see shmBufferHandOver()
+        * @param flags   flags the buffer is set to, replacing the lock
+        * @return true if successful
+        */
+        bool shmMsgCommit( unsigned int flags = RDB_SHM_BUFFER_FLAG_TC );
+        
+        /**
+        * drop the message composed in SHM and release the buffer
+        */
+        void shmMsgAbort();
+        
         /**
         * get the number of buffers in the SHM segment
         * @return number of buffers in SHM segment
@@ -823,14 +928,141 @@ class RDBHandler
         
     private:
         /**
-        * the actual RDB message that is composed
+        * make room in a message buffer, growing it geometrically
+        * @param  buffer     the buffer, may be altered
+        * @param  capacity   size of the buffer, may be altered
+        * @param  owned      true if the buffer has been allocated with malloc(), set once it has been replaced; 0 if it cannot grow
+        * @param  usedSize   number of bytes of the buffer which are to be preserved
+        * @param  size       size that is required
+        * @return true if successful
+        */
+        static bool reserveMsg( RDB_MSG_t* & buffer, size_t & capacity, bool* owned, size_t usedSize, size_t size );
+        
+        /**
+        * add a packet or series of packets to a message composed in a buffer; see addPackage() for the parameters
+        * @param  buffer     the buffer, may be altered
+        * @param  capacity   size of the buffer, may be altered
+        * @param  owned      true if the buffer has been allocated with malloc(), set once it has been replaced; 0 if it cannot grow
+        * @param  newMsg     true if a new message is to be started at the beginning of the buffer
+        * @param  lastEntry  offset of the last entry header in the message, 0 if unknown; set to the entry that has been extended / added
+        * @param  clearTrailingData  if false, only the packages are cleared, not the trailing data of their elements
+        * @return pointer where to start inserting the data, otherwise 0
+        */
+        static void* appendPackage( RDB_MSG_t* & buffer, size_t & capacity, bool* owned, bool newMsg, uint32_t & lastEntry,
+                                    const double & simTime, const unsigned int & simFrame, 
+                                    unsigned int pkgId, unsigned int noElements, bool extended, size_t trailingData, 
+                                    bool isCustom, bool clearTrailingData );
+        
+        /**
+        * compute the usage of an SHM buffer by walking its messages
+        * @param  index      index of the buffer which shall be queried
+        * @return number of bytes occupied in the buffer
+        */
+        unsigned int shmBufferCountUsedSize( unsigned int index );
+        
+        /**
+        * search a message for its last entry
+        * @param  msg        the message, holding at least one entry
+        * @return offset of the last entry header from the start of the message
+        */
+        static uint32_t findLastEntry( RDB_MSG_t* msg );
+        
+        /**
+        * get the elements of an entry
+        * @param  entryHdr   header of the entry, may be 0
+        * @param  pkgId      id (i.e. type) of the entry
+        * @param  noElements number of elements of the entry (will be altered)
+        * @return pointer to first element of the entry or 0 if there is none
+        */
+        static void* getEntryData( RDB_MSG_ENTRY_HDR_t* entryHdr, unsigned int pkgId, unsigned int & noElements );
+        
+        /**
+        * add an entry of the internally held message to the entry index
+        * @param  offset     offset of the entry header from the start of the message
+        */
+        void indexEntry( uint32_t offset );
+        
+        /**
+        * empty the entry index and the last entry cursor
+        */
+        void clearEntryIndex();
+        
+        /**
+        * index the entries of a message which has not been composed by the handler itself
+        */
+        void rebuildEntryIndex();
+        
+    private:
+        /**
+        * the actual RDB message that is composed, 0 if none has been started
         */
         RDB_MSG_t* mMsg;
         
+        /**
+        * memory in which the message is composed, kept from one message to the next
+        */
+        RDB_MSG_t* mMsgBuffer;
+        
+        /**
+        * size of the memory in which the message is composed
+        */
+        size_t mMsgCapacity;
+        
+        /**
+        * true if the memory has been allocated by the handler, false if provided by the caller
+        */
+        bool mMsgOwned;
+        
+        /**
+        * offset of the last entry header of the message, where the next package may be appended
+        */
+        uint32_t mLastEntry;
+        
+        /**
+        * offset of the first entry header per package id and extension (pkgId * 2 + extended), 0 if none
+        */
+        std::vector<uint32_t> mEntryIndex;
+        
+        /**
+        * keys of the entry index which have been set for the current message
+        */
+        std::vector<uint32_t> mEntryKeys;
+        
+        /**
+        * false if the message has been set from outside and its entries have not been indexed yet
+        */
+        bool mEntryIndexValid;
+        
         /**
         * pointer to the start of the shared memory segment
         */
         RDB_SHM_HDR_t* mShmHdr;
+        
+        /**
+        * message which is being composed in SHM, 0 if none
+        */
+        RDB_MSG_t* mShmMsg;
+        
+        /**
+        * index of the buffer holding the message which is being composed in SHM
+        */
+        unsigned int mShmMsgIndex;
+        
+        /**
+        * room for the message which is being composed in SHM
+        */
+        size_t mShmMsgCapacity;
+        
+        /**
+        * offset of the last entry header of the message which is being composed in SHM
+        */
+        uint32_t mShmLastEntry;
+        
+        /**
+        * usage of the buffer at which the message being composed in SHM has been begun; it is
+        * restored if the message is aborted (0 if the message replaces the messages of the buffer)
+        */
+        size_t mShmPrevUsedSize;
 };
 } // namespace Framework
 #endif /* _FRAMEWORK_RDB_HANDLER_HH */
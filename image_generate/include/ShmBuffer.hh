@@ -0,0 +1,119 @@
+/* ===================================================
+ *  file:       ShmBuffer.hh
+ * ---------------------------------------------------
+ *  purpose:	lock-free ownership protocol of the
+ *              buffers of an RDB shared memory segment
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_SHM_BUFFER_HH
+#define _FRAMEWORK_SHM_BUFFER_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdint.h>
+#include "viRDBIcd.h"
+
+/* ====== DEFINITIONS ====== */
+#define SHM_BUFFER_GENERATION   0       // word of RDB_SHM_BUFFER_INFO_t::spare1 holding the generation of the buffer contents
+#define SHM_BUFFER_USED_SIZE    1       // word of RDB_SHM_BUFFER_INFO_t::spare1 holding the number of bytes the messages take
+
+namespace Framework
+{
+
+/**
+* The flags of a buffer are shared by the producer and the readers of the segment, so every
+* transition is a single compare-and-swap on the flags word: a transition only takes place if
+* the flags are still in the state it has been decided on.
+*
+* The generation of a buffer is a sequence lock in a spare word of the buffer info: odd while
+* the producer writes the buffer, incremented to the next even value once it is done. A reader
+* may look at the contents of a buffer it has not locked and validate afterwards that what it
+* has seen is consistent. Producers not knowing about the generation leave it at 0, which
+* always validates.
+*
+* The number of bytes the messages of a buffer take is kept in another spare word, so that
+* appending a message does not have to walk the messages before it.
+*/
+
+/**
+* get the flags of a buffer
+* @param info   info block of the buffer
+* @return flags of the buffer
+*/
+uint32_t shmBufferGetFlags( const RDB_SHM_BUFFER_INFO_t* info );
+
+/**
+* change the flags of a buffer atomically, provided they are in a given state
+* @param info           info block of the buffer
+* @param requireAny     at least one of these flags has to be set, 0 = none
+* @param requireClear   all of these flags have to be clear
+* @param set            flags which are to be set
+* @param clear          flags which are to be cleared
+* @param prevFlags      if given, receives the flags found
+* @return true if the flags have been changed, false if they were not in the required state
+*/
+bool shmBufferChangeFlags( RDB_SHM_BUFFER_INFO_t* info, uint32_t requireAny, uint32_t requireClear,
+                           uint32_t set, uint32_t clear, uint32_t* prevFlags = 0 );
+
+/**
+* lock a buffer if it is not locked and carries one of the flags of a check mask
+* @param info           info block of the buffer
+* @param checkMask      flags of which at least one has to be set, 0 = none
+* @return true if the buffer has been locked by the caller
+*/
+bool shmBufferTryLock( RDB_SHM_BUFFER_INFO_t* info, uint32_t checkMask = 0 );
+
+/**
+* release the lock of a buffer, clearing other flags at the same time
+* @param info           info block of the buffer
+* @param clear          flags which are to be cleared together with the lock
+*/
+void shmBufferUnlock( RDB_SHM_BUFFER_INFO_t* info, uint32_t clear = 0 );
+
+/**
+* start writing the contents of a buffer (producer side); the generation becomes odd
+* @param info           info block of the buffer
+*/
+void shmBufferBeginWrite( RDB_SHM_BUFFER_INFO_t* info );
+
+/**
+* finish writing the contents of a buffer (producer side); the generation becomes even again
+* @param info           info block of the buffer
+*/
+void shmBufferEndWrite( RDB_SHM_BUFFER_INFO_t* info );
+
+/**
+* get the number of bytes the messages of a buffer take
+* @param info           info block of the buffer
+* @return number of bytes, 0 if the producer does not keep the count
+*/
+uint32_t shmBufferGetUsedSize( const RDB_SHM_BUFFER_INFO_t* info );
+
+/**
+* set the number of bytes the messages of a buffer take (producer side)
+* @param info           info block of the buffer
+* @param size           number of bytes
+*/
+void shmBufferSetUsedSize( RDB_SHM_BUFFER_INFO_t* info, uint32_t size );
+
+/**
+* start reading the contents of a buffer without locking it
+* @param info           info block of the buffer
+* @param generation     receives the generation, to be passed to shmBufferCheckRead()
+* @return false if the producer is writing the buffer right now
+*/
+bool shmBufferBeginRead( const RDB_SHM_BUFFER_INFO_t* info, uint32_t & generation );
+
+/**
+* check whether a buffer has not been written since shmBufferBeginRead()
+* @param info           info block of the buffer
+* @param generation     generation returned by shmBufferBeginRead()
+* @return true if everything read from the buffer in between is consistent
+*/
+bool shmBufferCheckRead( const RDB_SHM_BUFFER_INFO_t* info, uint32_t generation );
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_SHM_BUFFER_HH */
@@ -0,0 +1,210 @@
+/* ===================================================
+ *  file:       ShmNotify.hh
+ * ---------------------------------------------------
+ *  purpose:	wake-up notification for readers of an
+ *              RDB shared memory segment
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_SHM_NOTIFY_HH
+#define _FRAMEWORK_SHM_NOTIFY_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stdint.h>
+#include <string>
+
+namespace Framework
+{
+
+/**
+* layout of the doorbell segment which is placed next to an RDB SHM segment;
+* the producer increments "seq" each time it has set the check mask of a buffer
+*/
+typedef struct
+{
+    uint32_t  magicNo;      /**< RDB_MAGIC_NO once the doorbell is initialized                  */
+    uint32_t  seq;          /**< futex word, incremented on every ring                          */
+    uint32_t  waiters;      /**< number of readers currently sleeping on the doorbell           */
+    uint32_t  spare0;       /**< just a spare                                                   */
+    uint64_t  ringTime;     /**< CLOCK_MONOTONIC time of the last ring                 @unit ns */
+} RDB_SHM_DOORBELL_t;
+
+/**
+* get the current time of the monotonic (system-wide) clock
+* @return time in nanoseconds
+*/
+uint64_t monotonicNs();
+
+/**
+* sleep until the monotonic clock reaches a given time; producers pace their frames with this
+* @param timeNs time in nanoseconds at which to return
+* @return true if the time has been reached, false if the sleep was interrupted by a signal
+*/
+bool sleepUntil( uint64_t timeNs );
+
+/**
+* parse an SHM key given in the command line; keys are decimal unless prefixed by 0x,
+* a leading zero does not make them octal, so that all tools agree on the segment
+* @param text   the key
+* @param end    receives the position behind the key, 0 = not needed
+* @return the key
+*/
+unsigned int parseShmKey( const char* text, char** end = 0 );
+
+/**
+* doorbell attached to an RDB shared memory segment; it lives in a POSIX
+* shared memory object whose name is derived from the SHM key, so producer
+* and readers find it without changing the layout of the RDB segment
+*/
+class ShmDoorbell
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit ShmDoorbell();
+
+        /**
+        * destructor, closes the doorbell
+        */
+        virtual ~ShmDoorbell();
+
+        /**
+        * open (and create, if necessary) the doorbell of a given SHM key
+        * @param shmKey key of the RDB SHM segment the doorbell belongs to
+        * @return true if successful
+        */
+        bool open( unsigned int shmKey );
+
+        /**
+        * close the doorbell
+        */
+        void close();
+
+        /**
+        * check whether the doorbell is open
+        * @return true if open
+        */
+        bool isOpen() const;
+
+        /**
+        * check whether the producer has ever rung the doorbell
+        * @return true if the doorbell has been rung at least once
+        */
+        bool hasRung() const;
+
+        /**
+        * get the sequence number of the doorbell without waiting
+        * @return number of rings so far, 0 if not open
+        */
+        uint32_t getSeq() const;
+
+        /**
+        * ring the doorbell (producer side); call this after the check mask of a buffer has been set
+        */
+        void ring();
+
+        /**
+        * wait until the doorbell is rung (reader side)
+        * @param lastSeq    sequence number seen by the caller; updated on return
+        * @param timeoutUs  maximum time to wait
+        * @return true if the doorbell was rung, false on timeout
+        */
+        bool wait( uint32_t & lastSeq, unsigned int timeoutUs );
+
+        /**
+        * get the time of the last ring
+        * @return CLOCK_MONOTONIC time in nanoseconds
+        */
+        uint64_t lastRingTime() const;
+
+        /**
+        * get the name of the doorbell object for a given SHM key
+        * @param shmKey key of the RDB SHM segment
+        * @return name of the POSIX shared memory object
+        */
+        static std::string name( unsigned int shmKey );
+
+    private:
+        /**
+        * the mapped doorbell
+        */
+        RDB_SHM_DOORBELL_t* mBell;
+};
+
+/**
+* spin-then-sleep waiting strategy for producers which do not ring a doorbell;
+* the spin budget grows while data keeps arriving during the spin phase and
+* shrinks while it only arrives after sleeping
+*/
+class AdaptiveWaiter
+{
+    public:
+        /**
+        * predicate which tells whether data is ready
+        */
+        typedef bool ( *ReadyFunc )( void* userData );
+
+        /**
+        * constructor
+        * @param maxSpinUs  upper limit of the busy-waiting phase
+        * @param maxSleepUs upper limit of a single sleep step
+        */
+        explicit AdaptiveWaiter( unsigned int maxSpinUs = 200, unsigned int maxSleepUs = 1000 );
+
+        /**
+        * wait until the predicate becomes true or the timeout expires
+        * @param ready      predicate to be polled
+        * @param userData   argument passed to the predicate
+        * @param timeoutUs  maximum time to wait (0 = forever)
+        * @return true if data is ready
+        */
+        bool wait( ReadyFunc ready, void* userData, unsigned int timeoutUs = 0 );
+
+        /**
+        * get the time of the last probe which found no data; the difference to the
+        * time of the successful probe is the upper bound of the detection delay
+        * @return CLOCK_MONOTONIC time in nanoseconds
+        */
+        uint64_t lastMissTime() const;
+
+    private:
+        unsigned int mMaxSpinUs;
+        unsigned int mMaxSleepUs;
+        unsigned int mSpinUs;
+        uint64_t     mLastMiss;
+};
+
+/**
+* accumulator for durations such as wake-up latencies or processing times
+*/
+class TimingStats
+{
+    public:
+        explicit TimingStats();
+
+        /**
+        * add a sample
+        * @param durationNs  a single duration
+        */
+        void add( uint64_t durationNs );
+
+        /**
+        * print the statistics and optionally reset them
+        * @param label  label printed in front of the numbers, naming the measured quantity
+        * @param reset  reset after printing
+        */
+        void print( const char* label, bool reset = false );
+
+    private:
+        uint64_t mCount;
+        uint64_t mSumNs;
+        uint64_t mMinNs;
+        uint64_t mMaxNs;
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_SHM_NOTIFY_HH */
@@ -0,0 +1,155 @@
+/* ===================================================
+ *  file:       ShmSegment.hh
+ * ---------------------------------------------------
+ *  purpose:	attachment to an RDB shared memory segment
+ *              with a cached buffer table
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_SHM_SEGMENT_HH
+#define _FRAMEWORK_SHM_SEGMENT_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <time.h>
+#include <vector>
+#include "viRDBIcd.h"
+
+namespace Framework
+{
+
+/**
+* an attached RDB shared memory segment; the pointers to the buffer info blocks
+* and to the messages of each buffer are computed once and only recomputed when
+* the segment header changes, so that polling the segment does not allocate
+*/
+class ShmSegment
+{
+    public:
+        /**
+        * constructor
+        */
+        explicit ShmSegment();
+
+        /**
+        * destructor, detaches from the segment
+        */
+        virtual ~ShmSegment();
+
+        /**
+        * attach to an existing segment (without creating a new one)
+        * @param shmKey key of the SHM segment
+        * @return true if successful
+        */
+        bool attach( unsigned int shmKey );
+
+        /**
+        * detach from the segment
+        */
+        void detach();
+
+        /**
+        * check whether the segment is attached
+        * @return true if attached
+        */
+        bool isAttached() const;
+
+        /**
+        * check whether the attached segment is still the one the producer works with; a restarted
+        * producer removes the segment or replaces it by a new one under the same key, while the old
+        * one stays mapped here. Costs two system calls, so it is only to be called while no data arrives.
+        * @return true if the segment is current, false if it is to be detached and attached again
+        */
+        bool isCurrent();
+
+        /**
+        * get the number of processes attached to the segment, as of the last isCurrent()
+        * @return number of processes, including this one
+        */
+        unsigned int getNoAttached() const;
+
+        /**
+        * make sure the cached buffer table matches the segment header; the
+        * table is only rebuilt if the header or the buffer layout has changed
+        * @return true if the segment holds a usable buffer table
+        */
+        bool validate();
+
+        /**
+        * get the pointer to the segment header
+        * @return pointer to the header or 0 if not attached
+        */
+        RDB_SHM_HDR_t* getHdr() const;
+
+        /**
+        * get the start address of the segment
+        * @return start address or 0 if not attached
+        */
+        void* getPtr() const;
+
+        /**
+        * get the total size of the segment
+        * @return size in bytes
+        */
+        size_t getTotalSize() const;
+
+        /**
+        * get the number of buffers in the cached table
+        * @return number of buffers
+        */
+        unsigned int getNoBuffers() const;
+
+        /**
+        * get the info block of a buffer
+        * @param index  index of the buffer
+        * @return pointer to the info block or 0 if the index is invalid
+        */
+        RDB_SHM_BUFFER_INFO_t* getBufferInfo( unsigned int index ) const;
+
+        /**
+        * get the first message of a buffer
+        * @param index  index of the buffer
+        * @return pointer to the message or 0 if the index is invalid
+        */
+        RDB_MSG_t* getMsg( unsigned int index ) const;
+
+    private:
+        /**
+        * check whether the header still matches the cached table
+        * @return true if unchanged
+        */
+        bool isUnchanged() const;
+
+        /**
+        * rebuild the buffer table from the header
+        * @return true if the header describes a valid layout
+        */
+        bool rebuild();
+
+    private:
+        void*   mShmPtr;            // pointer to the SHM segment
+        size_t  mShmTotalSize;      // total size of the SHM segment
+        int     mShmKey;            // key the segment has been attached by
+        int     mShmId;             // id of the attached segment
+        time_t  mCtime;             // time of the last change of the segment by shmctl() at attaching
+        unsigned int mNoAttached;   // number of attached processes at the last check
+
+        /**
+        * header values the table has been built from
+        */
+        uint32_t mHdrSize;
+        uint32_t mDataSize;
+        uint8_t  mNoBuffers;
+        bool     mValid;
+
+        std::vector<RDB_SHM_BUFFER_INFO_t*> mBufferInfo;     // info block of each buffer
+        std::vector<RDB_MSG_t*>             mMsg;            // first message of each buffer
+        std::vector<uint32_t>               mOffset;         // offsets the message pointers were computed from
+        std::vector<uint32_t>               mThisSize;       // sizes of the info blocks
+};
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_SHM_SEGMENT_HH */
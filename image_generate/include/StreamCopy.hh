@@ -0,0 +1,73 @@
+/* ===================================================
+ *  file:       StreamCopy.hh
+ * ---------------------------------------------------
+ *  purpose:	copy of large payloads with non-temporal
+ *              stores, so that they do not evict the
+ *              working sets of other threads from cache
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_STREAM_COPY_HH
+#define _FRAMEWORK_STREAM_COPY_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+
+namespace Framework
+{
+
+/**
+* copy a block of memory; blocks of at least the streaming threshold are copied with
+* non-temporal stores and software prefetching, smaller ones with memcpy(). The
+* stores are fenced before returning, so the data may be handed to another thread.
+* @param dst    destination
+* @param src    source
+* @param size   number of bytes
+*/
+void streamCopy( void* dst, const void* src, size_t size );
+
+/**
+* copy a block of memory with non-temporal stores regardless of its size; the caller
+* has to call streamCopyFence() before handing the data to another thread
+* @param dst    destination
+* @param src    source
+* @param size   number of bytes
+*/
+void streamCopyUnfenced( void* dst, const void* src, size_t size );
+
+/**
+* order the non-temporal stores of streamCopyUnfenced() before the following stores
+*/
+void streamCopyFence();
+
+/**
+* check whether a payload is large enough to be copied with non-temporal stores
+* @param size   size of the payload
+* @return true if it is
+*/
+bool streamCopyUsed( size_t size );
+
+/**
+* set the size from which on payloads are copied with non-temporal stores
+* @param threshold  size in bytes, 0 = never
+*/
+void setStreamCopyThreshold( size_t threshold );
+
+/**
+* get the size from which on payloads are copied with non-temporal stores; by default,
+* this is the share of a core in the last level cache, at least the L2 cache
+* @return size in bytes, 0 = never
+*/
+size_t getStreamCopyThreshold();
+
+/**
+* get the name of the SIMD variant used for non-temporal copies
+* @return name of the variant
+*/
+const char* streamCopyIsa();
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_STREAM_COPY_HH */
@@ -0,0 +1,65 @@
+/* ===================================================
+ *  file:       ThreadTuning.hh
+ * ---------------------------------------------------
+ *  purpose:	CPU affinity, real-time scheduling and
+ *              memory locking of the reader's threads
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+#ifndef _FRAMEWORK_THREAD_TUNING_HH
+#define _FRAMEWORK_THREAD_TUNING_HH
+
+/* ====== INCLUSIONS ====== */
+#include <stddef.h>
+#include <sched.h>
+#include <pthread.h>
+
+namespace Framework
+{
+
+/**
+* parse a list of CPUs such as "2,4-7"
+* @param list   the list
+* @param cpus   receives the CPUs
+* @return true if the list is valid and not empty
+*/
+bool parseCpuList( const char* list, cpu_set_t & cpus );
+
+/**
+* restrict a thread to a set of CPUs
+* @param thread the thread
+* @param cpus   the CPUs
+* @return true if successful
+*/
+bool setThreadAffinity( pthread_t thread, const cpu_set_t & cpus );
+
+/**
+* schedule a thread with SCHED_FIFO
+* @param thread   the thread
+* @param priority real-time priority, 1..99
+* @return true if successful
+*/
+bool setThreadRealtime( pthread_t thread, int priority );
+
+/**
+* schedule a thread with SCHED_OTHER again, e.g. after it has inherited a real-time policy
+* from the thread which created it
+* @param thread the thread
+* @return true if successful
+*/
+bool setThreadNormal( pthread_t thread );
+
+/**
+* lock a memory range into RAM and fault all of its pages in, so that they are mapped
+* before their first use; if locking is not permitted, the pages are still faulted in
+* @param ptr    start of the range
+* @param size   size of the range
+* @return true if the range has been locked
+*/
+bool lockMemory( void* ptr, size_t size );
+
+} // namespace Framework
+
+#endif /* _FRAMEWORK_THREAD_TUNING_HH */
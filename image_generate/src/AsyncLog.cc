@@ -0,0 +1,280 @@
+/* ===================================================
+ *  file:       AsyncLog.cc
+ * ---------------------------------------------------
+ *  purpose:	logging out of the frame path: messages
+ *              are formatted into a lock-free ring and
+ *              written to stderr by a background thread
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <string.h>
+#include <chrono>
+#include "AsyncLog.hh"
+#include "ShmNotify.hh"
+
+namespace Framework
+{
+
+std::atomic<int> AsyncLog::sLevel( LOG_LEVEL_INFO );
+
+/**
+* format a message, append the number of suppressed messages and make sure it ends with a newline
+* @param buffer      receives the message, ASYNC_LOG_MSG_SIZE bytes
+* @param suppressed  number of suppressed messages, 0 if none
+* @param format      printf-style format
+* @param args        arguments of the format
+* @return length of the message
+*/
+static unsigned int
+formatMessage( char* buffer, unsigned int suppressed, const char* format, va_list args )
+{
+    int length = vsnprintf( buffer, ASYNC_LOG_MSG_SIZE, format, args );
+
+    if ( length < 0 )
+        length = 0;
+
+    // cut messages end with the newline, too
+    if ( length > ASYNC_LOG_MSG_SIZE - 2 )
+        length = ASYNC_LOG_MSG_SIZE - 2;
+
+    if ( length && ( buffer[ length - 1 ] == '\n' ) )
+        length--;
+
+    if ( suppressed )
+    {
+        int extra = snprintf( buffer + length, ASYNC_LOG_MSG_SIZE - 1 - length, " (%u similar messages suppressed)", suppressed );
+
+        if ( extra > 0 )
+            length += ( extra < ASYNC_LOG_MSG_SIZE - 2 - length ) ? extra : ASYNC_LOG_MSG_SIZE - 2 - length;
+    }
+
+    buffer[ length++ ] = '\n';
+    buffer[ length ]   = 0;
+
+    return length;
+}
+
+bool
+LogRateLimit::allow( uint64_t intervalNs, unsigned int & suppressed )
+{
+    uint64_t now  = monotonicNs();
+    uint64_t next = mNext.load( std::memory_order_relaxed );
+
+    // of concurrent callers, only the one which moves the window on may log
+    if ( ( now < next ) || !mNext.compare_exchange_strong( next, now + intervalNs, std::memory_order_relaxed ) )
+    {
+        mSuppressed.fetch_add( 1, std::memory_order_relaxed );
+        return false;
+    }
+
+    suppressed = mSuppressed.exchange( 0, std::memory_order_relaxed );
+
+    return true;
+}
+
+AsyncLog::AsyncLog() : mHead( 0 ),
+                       mTail( 0 ),
+                       mRunning( false ),
+                       mNoPushing( 0 ),
+                       mNoDropped( 0 ),
+                       mNoReported( 0 )
+{
+    for ( unsigned int i = 0; i < ASYNC_LOG_NO_SLOTS; i++ )
+        mSlots[ i ].seq.store( i, std::memory_order_relaxed );
+}
+
+AsyncLog::~AsyncLog()
+{
+    stop();
+}
+
+AsyncLog&
+AsyncLog::instance()
+{
+    static AsyncLog sInstance;
+
+    return sInstance;
+}
+
+void
+AsyncLog::setLevel( int level )
+{
+    sLevel.store( level, std::memory_order_relaxed );
+}
+
+bool
+AsyncLog::start( unsigned int intervalMs )
+{
+    if ( mRunning )
+        return true;
+
+    mRunning = true;
+
+    try
+    {
+        mThread = std::thread( &AsyncLog::run, this, intervalMs );
+    }
+    catch ( ... )
+    {
+        fprintf( stderr, "AsyncLog::start: failed to start the writer thread\n" );
+        mRunning = false;
+        return false;
+    }
+
+    return true;
+}
+
+void
+AsyncLog::stop()
+{
+    if ( !mRunning )
+        return;
+
+    // messages logged from now on are written directly
+    mRunning = false;
+
+    if ( mThread.joinable() )
+        mThread.join();
+
+    // producers which have seen the logger running may still be filling their slots
+    while ( mNoPushing.load( std::memory_order_seq_cst ) )
+        std::this_thread::yield();
+
+    drain();
+}
+
+void
+AsyncLog::log( int level, const char* format, ... )
+{
+    if ( !enabled( level ) )
+        return;
+
+    va_list args;
+
+    va_start( args, format );
+    push( 0, format, args );
+    va_end( args );
+}
+
+void
+AsyncLog::logSuppressed( int level, unsigned int suppressed, const char* format, ... )
+{
+    if ( !enabled( level ) )
+        return;
+
+    va_list args;
+
+    va_start( args, format );
+    push( suppressed, format, args );
+    va_end( args );
+}
+
+void
+AsyncLog::push( unsigned int suppressed, const char* format, va_list args )
+{
+    // stop() waits for this count to drop to 0 before it writes the ring for the last time,
+    // so a producer either sees the logger stopped or its message is written by stop()
+    mNoPushing.fetch_add( 1, std::memory_order_seq_cst );
+
+    if ( !mRunning.load( std::memory_order_seq_cst ) )
+    {
+        mNoPushing.fetch_sub( 1, std::memory_order_relaxed );
+
+        char buffer[ ASYNC_LOG_MSG_SIZE ];
+
+        formatMessage( buffer, suppressed, format, args );
+        fputs( buffer, stderr );
+        return;
+    }
+
+    uint64_t pos = mHead.load( std::memory_order_relaxed );
+    Slot*    slot;
+
+    // claim a slot: its sequence equals the position while it is free for this round
+    for ( ;; )
+    {
+        slot = &mSlots[ pos & ( ASYNC_LOG_NO_SLOTS - 1 ) ];
+
+        int64_t diff = ( int64_t ) ( slot->seq.load( std::memory_order_acquire ) - pos );
+
+        if ( !diff )
+        {
+            if ( mHead.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                break;
+        }
+        else if ( diff < 0 )
+        {
+            // the writer has not yet caught up with this slot
+            mNoDropped.fetch_add( 1, std::memory_order_relaxed );
+            mNoPushing.fetch_sub( 1, std::memory_order_release );
+            return;
+        }
+        else
+            pos = mHead.load( std::memory_order_relaxed );
+    }
+
+    slot->length = formatMessage( slot->text, suppressed, format, args );
+    slot->seq.store( pos + 1, std::memory_order_release );
+
+    mNoPushing.fetch_sub( 1, std::memory_order_release );
+}
+
+unsigned int
+AsyncLog::drain()
+{
+    // the messages are collected, so that a burst costs a single write
+    char         buffer[ 16384 ];
+    size_t       used    = 0;
+    unsigned int noMsgs  = 0;
+
+    for ( ;; )
+    {
+        Slot* slot = &mSlots[ mTail & ( ASYNC_LOG_NO_SLOTS - 1 ) ];
+
+        if ( slot->seq.load( std::memory_order_acquire ) != mTail + 1 )
+            break;
+
+        if ( used + slot->length > sizeof( buffer ) )
+        {
+            fwrite( buffer, 1, used, stderr );
+            used = 0;
+        }
+
+        memcpy( buffer + used, slot->text, slot->length );
+        used += slot->length;
+
+        slot->seq.store( mTail + ASYNC_LOG_NO_SLOTS, std::memory_order_release );
+        mTail++;
+        noMsgs++;
+    }
+
+    if ( used )
+        fwrite( buffer, 1, used, stderr );
+
+    unsigned int noDropped = mNoDropped.load( std::memory_order_relaxed );
+
+    if ( noDropped != mNoReported )
+    {
+        fprintf( stderr, "AsyncLog: %u messages dropped, the log ring was full\n", noDropped - mNoReported );
+        mNoReported = noDropped;
+    }
+
+    return noMsgs;
+}
+
+void
+AsyncLog::run( unsigned int intervalMs )
+{
+    // polling keeps the producers free of any wake-up call
+    while ( mRunning.load( std::memory_order_relaxed ) )
+    {
+        if ( !drain() )
+            std::this_thread::sleep_for( std::chrono::milliseconds( intervalMs ) );
+    }
+}
+
+} // namespace Framework
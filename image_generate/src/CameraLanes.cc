@@ -0,0 +1,293 @@
+/* ===================================================
+ *  file:       CameraLanes.cc
+ * ---------------------------------------------------
+ *  purpose:	routing of images by camera into lanes
+ *              with their own encoders and statistics
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <errno.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include "CameraLanes.hh"
+#include "ShmNotify.hh"
+#include "AsyncLog.hh"
+
+namespace Framework
+{
+
+bool
+isSimRestart( uint32_t seq, uint32_t last, uint32_t step, double simTime, double lastSimTime, double startSimTime )
+{
+    if ( seq >= last )
+        return false;
+
+    // a late arrival is newer than the start of the run; producers without a time never reset it
+    if ( ( simTime < lastSimTime ) && ( simTime <= startSimTime ) )
+        return true;
+
+    return last - seq > FRAME_RESTART_STEP * ( step ? step : 1 );
+}
+
+CameraLane::CameraLane( uint16_t id, const std::string & dir ) : cameraId( id ),
+                                                                 outputDir( dir ),
+                                                                 noFrames( 0 ),
+                                                                 noDropped( 0 ),
+                                                                 noBytes( 0 ),
+                                                                 noReceived( 0 ),
+                                                                 noMissing( 0 ),
+                                                                 noDuplicate( 0 ),
+                                                                 noOutOfOrder( 0 ),
+                                                                 noRestarts( 0 ),
+                                                                 tFirst( 0 ),
+                                                                 tLast( 0 ),
+                                                                 mLastSimFrame( 0 ),
+                                                                 mCounter( 0 ),
+                                                                 mLastFrameNo( 0 ),
+                                                                 mLastImageId( 0 ),
+                                                                 mFrameStride( 0 ),
+                                                                 mLastSimTime( 0.0 ),
+                                                                 mStartSimTime( 0.0 )
+{
+}
+
+CameraLane::~CameraLane()
+{
+    encoders.stop();
+}
+
+int
+CameraLane::nextCounter( unsigned int simFrame )
+{
+    if ( simFrame != mLastSimFrame )
+        mCounter = 0;
+
+    mLastSimFrame = simFrame;
+
+    return ++mCounter;
+}
+
+void
+CameraLane::track( uint32_t frameNo, uint32_t imageId, double simTime )
+{
+    tLast = monotonicNs();
+
+    if ( !noReceived++ )
+    {
+        tFirst        = tLast;
+        mLastFrameNo  = frameNo;
+        mLastImageId  = imageId;
+        mLastSimTime  = simTime;
+        mStartSimTime = simTime;
+        return;
+    }
+
+    // the image id counts the images of the camera; without it, the frame numbers are used,
+    // taking into account that the camera may render only every n-th frame of the simulation
+    bool     useId = imageId || mLastImageId;
+    uint32_t last  = useId ? mLastImageId : mLastFrameNo;
+    uint32_t seq   = useId ? imageId : frameNo;
+
+    if ( seq == last )
+        noDuplicate++;
+    else if ( seq < last )
+    {
+        if ( isSimRestart( seq, last, useId ? 1 : mFrameStride, simTime, mLastSimTime, mStartSimTime ) )
+        {
+            noRestarts++;
+            mFrameStride  = 0;
+            mStartSimTime = simTime;
+        }
+        else
+        {
+            noOutOfOrder++;
+
+            // it has been counted as missing when the newer image arrived
+            if ( noMissing )
+                noMissing--;
+
+            return;
+        }
+    }
+    else
+    {
+        uint32_t step = seq - last;
+
+        if ( !useId )
+        {
+            if ( !mFrameStride || ( step < mFrameStride ) )
+                mFrameStride = step;
+
+            step /= mFrameStride;
+        }
+
+        noMissing += step - 1;
+    }
+
+    mLastFrameNo = frameNo;
+    mLastImageId = imageId;
+    mLastSimTime = simTime;
+}
+
+CameraRouter::CameraRouter() : mEncode( 0 ),
+                               mNoThreads( 1 ),
+                               mQueueDepth( 0 ),
+                               mOutputDir( "." ),
+                               mPolicy( BACKPRESSURE_DROP_NEWEST ),
+                               mSharedBudget( 0 ),
+                               mWorkers( 0 ),
+                               mHasCpus( false )
+{
+}
+
+CameraRouter::~CameraRouter()
+{
+    // shared workers serve other routers as well, so they are stopped by their owner before the lanes are deleted
+    for ( std::map<uint16_t, CameraLane*>::iterator it = mLanes.begin(); it != mLanes.end(); ++it )
+        delete it->second;
+}
+
+void
+CameraRouter::configure( EncoderPool::EncodeFunc encode, unsigned int noThreads, unsigned int queueDepth, const std::string & outputDir )
+{
+    mEncode     = encode;
+    mNoThreads  = noThreads;
+    mQueueDepth = queueDepth;
+    mOutputDir  = outputDir;
+}
+
+void
+CameraRouter::setBackpressure( int policy, size_t memoryCap )
+{
+    mPolicy = policy;
+    mBudget.setLimit( memoryCap );
+}
+
+void
+CameraRouter::setAffinity( const cpu_set_t & cpus )
+{
+    mCpus    = cpus;
+    mHasCpus = true;
+}
+
+void
+CameraRouter::setBudget( MemoryBudget* budget )
+{
+    mSharedBudget = budget;
+}
+
+void
+CameraRouter::setWorkers( EncoderWorkers* workers )
+{
+    mWorkers = workers;
+}
+
+void
+CameraRouter::addCamera( uint16_t cameraId )
+{
+    mSelected.insert( cameraId );
+}
+
+CameraLane*
+CameraRouter::getLane( uint16_t cameraId )
+{
+    std::map<uint16_t, CameraLane*>::iterator it = mLanes.find( cameraId );
+
+    if ( it != mLanes.end() )
+        return it->second;
+
+    if ( !mSelected.empty() && !mSelected.count( cameraId ) )
+    {
+        mSkipped[ cameraId ]++;
+        return 0;
+    }
+
+    char dir[ 64 ];
+    snprintf( dir, sizeof( dir ), "/camera_%u", cameraId );
+
+    CameraLane* lane = new CameraLane( cameraId, mOutputDir + dir );
+
+    if ( ( mkdir( mOutputDir.c_str(), 0755 ) && ( errno != EEXIST ) ) || ( mkdir( lane->outputDir.c_str(), 0755 ) && ( errno != EEXIST ) ) )
+        FWLOG_ERROR( "CameraRouter::getLane: cannot create directory %s\n", lane->outputDir.c_str() );
+
+    lane->encoders.setBackpressure( mPolicy, mSharedBudget ? mSharedBudget : &mBudget, lane->outputDir + "/spill" );
+    lane->encoders.setAffinity( mHasCpus ? &mCpus : 0 );
+    lane->encoders.setWorkers( mWorkers );
+
+    if ( !lane->encoders.start( mEncode, mNoThreads, mQueueDepth ) )
+    {
+        FWLOG_ERROR( "CameraRouter::getLane: failed to start the encoders of camera %u\n", cameraId );
+        delete lane;
+        return 0;
+    }
+
+    FWLOG_INFO( "CameraRouter::getLane: camera %u is written to %s\n", cameraId, lane->outputDir.c_str() );
+
+    mLanes[ cameraId ] = lane;
+
+    return lane;
+}
+
+ImageFrame*
+CameraRouter::acquire( CameraLane* lane, size_t dataSize )
+{
+    ImageFrame* frame = lane->encoders.acquire( dataSize );
+
+    if ( !frame )
+    {
+        lane->noDropped++;
+        return 0;
+    }
+
+    frame->outputDir = lane->outputDir.c_str();
+
+    lane->noBytes += dataSize;
+
+    return frame;
+}
+
+void
+CameraRouter::submit( CameraLane* lane, ImageFrame* frame )
+{
+    lane->noFrames++;
+    lane->encoders.submit( frame );
+}
+
+void
+CameraRouter::stop()
+{
+    for ( std::map<uint16_t, CameraLane*>::iterator it = mLanes.begin(); it != mLanes.end(); ++it )
+        it->second->encoders.stop();
+}
+
+void
+CameraRouter::printStats( const char* label, bool reset )
+{
+    char text[ 256 ];
+
+    for ( std::map<uint16_t, CameraLane*>::iterator it = mLanes.begin(); it != mLanes.end(); ++it )
+    {
+        CameraLane* lane = it->second;
+
+        double elapsed = ( lane->tLast - lane->tFirst ) * 1.0e-9;
+        double rate    = ( elapsed > 0.0 ) ? ( lane->noReceived - 1 ) / elapsed : 0.0;
+
+        fprintf( stderr, "%s: camera %u: %u frames, %u dropped (encoders busy), %.1f MB, %.1f images/s received\n",
+                         label, lane->cameraId, lane->noFrames, lane->noDropped, lane->noBytes / 1048576.0, rate );
+
+        fprintf( stderr, "%s: camera %u: %u images received, %u missing (overwritten in the SHM), %u duplicated, %u out of order, %u restarts\n",
+                         label, lane->cameraId, lane->noReceived, lane->noMissing, lane->noDuplicate, lane->noOutOfOrder, lane->noRestarts );
+
+        snprintf( text, sizeof( text ), "%s: camera %u", label, lane->cameraId );
+        lane->encoders.printStats( text, reset );
+    }
+
+    for ( std::map<uint16_t, unsigned int>::iterator it = mSkipped.begin(); it != mSkipped.end(); ++it )
+        fprintf( stderr, "%s: camera %u: %u images skipped (no consumer)\n", label, it->first, it->second );
+}
+
+} // namespace Framework
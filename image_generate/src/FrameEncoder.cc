@@ -0,0 +1,781 @@
+/* ===================================================
+ *  file:       FrameEncoder.cc
+ * ---------------------------------------------------
+ *  purpose:	pool of image frames copied out of shared
+ *              memory and threads which encode them
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <chrono>
+#include "FrameEncoder.hh"
+#include "AsyncLog.hh"
+#include "ThreadTuning.hh"
+
+namespace Framework
+{
+
+MemoryBudget::MemoryBudget( size_t limit ) : mLimit( limit ),
+                                             mUsed( 0 )
+{
+}
+
+void
+MemoryBudget::setLimit( size_t limit )
+{
+    mLimit = limit;
+}
+
+bool
+MemoryBudget::reserve( size_t size )
+{
+    size_t used = mUsed.load();
+
+    do
+    {
+        // a single frame larger than the limit is let through, otherwise a blocking reader would wait forever
+        if ( mLimit && used && ( used + size > mLimit ) )
+            return false;
+    }
+    while ( !mUsed.compare_exchange_weak( used, used + size ) );
+
+    return true;
+}
+
+void
+MemoryBudget::release( size_t size )
+{
+    mUsed -= size;
+}
+
+EncoderPool::EncoderPool() : mEncode( 0 ),
+                             mStop( false ),
+                             mPolicy( BACKPRESSURE_DROP_NEWEST ),
+                             mBudget( 0 ),
+                             mSpillStop( false ),
+                             mSpillOutputDir( 0 ),
+                             mNoSpillFiles( 0 ),
+                             mNoReplaced( 0 ),
+                             mNoSpilled( 0 ),
+                             mNoUnspilled( 0 ),
+                             mNoBlocked( 0 ),
+                             mHasCpus( false ),
+                             mWorkers( 0 ),
+                             mNoActive( 0 ),
+                             mMaxActive( 0 )
+{
+    mSpillFrames.resize( ENCODER_POOL_SPILL_FRAMES );
+
+    for ( size_t i = 0; i < mSpillFrames.size(); i++ )
+    {
+        memset( &mSpillFrames[ i ], 0, sizeof( ImageFrame ) );
+        mSpillFree.push_back( &mSpillFrames[ i ] );
+    }
+}
+
+EncoderPool::~EncoderPool()
+{
+    stop();
+
+    for ( size_t i = 0; i < mFrames.size(); i++ )
+        free( mFrames[ i ].data );
+
+    for ( size_t i = 0; i < mSpillFrames.size(); i++ )
+        free( mSpillFrames[ i ].data );
+}
+
+void
+EncoderPool::setBackpressure( int policy, MemoryBudget* budget, const std::string & spillDir )
+{
+    mPolicy   = policy;
+    mBudget   = budget;
+    mSpillDir = spillDir;
+}
+
+void
+EncoderPool::setAffinity( const cpu_set_t* cpus )
+{
+    mHasCpus = ( cpus != 0 );
+
+    if ( cpus )
+        mCpus = *cpus;
+}
+
+void
+EncoderPool::setWorkers( EncoderWorkers* workers )
+{
+    mWorkers = workers;
+}
+
+bool
+EncoderPool::start( EncodeFunc encode, unsigned int noThreads, unsigned int queueDepth )
+{
+    if ( !encode || !noThreads || !mThreads.empty() )
+        return false;
+
+    mEncode    = encode;
+    mStop      = false;
+    mSpillStop = false;
+    mMaxActive = noThreads;
+
+    // every worker holds one frame, the others wait in the queue
+    mFrames.resize( noThreads + queueDepth );
+
+    for ( size_t i = 0; i < mFrames.size(); i++ )
+    {
+        memset( &mFrames[ i ], 0, sizeof( ImageFrame ) );
+        mFree.push_back( &mFrames[ i ] );
+    }
+
+    if ( mPolicy == BACKPRESSURE_SPILL )
+    {
+        mSpillThread = std::thread( &EncoderPool::runSpill, this );
+
+        setThreadNormal( mSpillThread.native_handle() );
+
+        if ( mHasCpus )
+            setThreadAffinity( mSpillThread.native_handle(), mCpus );
+    }
+
+    if ( mWorkers )
+        return mWorkers->attach( this );
+
+    for ( unsigned int i = 0; i < noThreads; i++ )
+    {
+        mThreads.push_back( std::thread( &EncoderPool::run, this ) );
+
+        // the lanes are started by the ingest thread, whose SCHED_FIFO must not spread to the encoders
+        setThreadNormal( mThreads.back().native_handle() );
+
+        if ( mHasCpus )
+            setThreadAffinity( mThreads.back().native_handle(), mCpus );
+    }
+
+    return true;
+}
+
+void
+EncoderPool::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mSpillStop = true;
+    }
+
+    // the spill frames are on disk before the workers are told to stop, so that they encode all of them
+    mSpillCond.notify_all();
+
+    if ( mSpillThread.joinable() )
+        mSpillThread.join();
+
+    {
+        std::unique_lock<std::mutex> lock( mMutex );
+        mStop = true;
+
+        // shared workers keep running for the other pools, so they are waited for until they have encoded the frames of this one
+        while ( mWorkers && mWorkers->isRunning() && ( !mQueue.empty() || !mSpilled.empty() || mNoActive ) )
+            mFreeCond.wait_for( lock, std::chrono::milliseconds( 1 ) );
+    }
+
+    mQueueCond.notify_all();
+    mFreeCond.notify_all();
+
+    for ( size_t i = 0; i < mThreads.size(); i++ )
+        mThreads[ i ].join();
+
+    mThreads.clear();
+}
+
+ImageFrame*
+EncoderPool::take( size_t dataSize )
+{
+    ImageFrame* frame      = 0;
+    bool        keepLatest = ( mPolicy == BACKPRESSURE_KEEP_LATEST ) && !mQueue.empty();
+
+    if ( !keepLatest && !mFree.empty() && ( !mBudget || mBudget->reserve( dataSize ) ) )
+    {
+        frame = mFree.back();
+        mFree.pop_back();
+
+        frame->dataSize = dataSize;
+        return frame;
+    }
+
+    // a full pool and a used up memory budget are treated alike
+    if ( !keepLatest && ( ( mPolicy != BACKPRESSURE_DROP_OLDEST ) || mQueue.empty() ) )
+        return 0;
+
+    // the oldest frame waiting for an encoder is superseded by the new one
+    frame = mQueue.front();
+
+    if ( mBudget && ( dataSize > frame->dataSize ) && !mBudget->reserve( dataSize - frame->dataSize ) )
+        return 0;
+
+    if ( mBudget && ( dataSize < frame->dataSize ) )
+        mBudget->release( frame->dataSize - dataSize );
+
+    mQueue.pop_front();
+    mNoReplaced++;
+
+    frame->dataSize = dataSize;
+
+    return frame;
+}
+
+bool
+EncoderPool::reserveData( ImageFrame* frame, size_t dataSize )
+{
+    // buffers only grow, so a steady stream of equal frames does not allocate
+    if ( frame->capacity >= dataSize )
+        return true;
+
+    char* data = ( char* ) realloc( frame->data, dataSize );
+
+    if ( !data )
+    {
+        FWLOG_RATE( LOG_LEVEL_ERROR, 1000, "EncoderPool::reserveData: out of memory.\n" );
+        return false;
+    }
+
+    frame->data     = data;
+    frame->capacity = dataSize;
+
+    return true;
+}
+
+ImageFrame*
+EncoderPool::acquire( size_t dataSize )
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    if ( mStop )
+        return 0;
+
+    ImageFrame* frame = take( dataSize );
+
+    if ( !frame && ( mPolicy == BACKPRESSURE_BLOCK ) )
+    {
+        uint64_t tWait = monotonicNs();
+
+        mNoBlocked++;
+
+        // the budget may be given back by another pool, which does not notify this one
+        while ( !frame && !mStop )
+        {
+            mFreeCond.wait_for( lock, std::chrono::milliseconds( 1 ) );
+            frame = mStop ? 0 : take( dataSize );
+        }
+
+        mBlockStats.add( monotonicNs() - tWait );
+    }
+
+    if ( !frame && ( mPolicy == BACKPRESSURE_SPILL ) && !mStop )
+    {
+        // both spill frames are only in use if the disk cannot keep up with the encoders falling behind
+        if ( mSpillFree.empty() )
+        {
+            uint64_t tWait = monotonicNs();
+
+            mNoBlocked++;
+
+            while ( mSpillFree.empty() && !frame && !mStop )
+            {
+                mFreeCond.wait_for( lock, std::chrono::milliseconds( 1 ) );
+                frame = mStop ? 0 : take( dataSize );
+            }
+
+            mBlockStats.add( monotonicNs() - tWait );
+        }
+
+        if ( !frame && !mSpillFree.empty() && !mStop )
+        {
+            frame = mSpillFree.back();
+            mSpillFree.pop_back();
+
+            frame->dataSize = dataSize;
+        }
+    }
+
+    lock.unlock();
+
+    if ( frame && !reserveData( frame, dataSize ) )
+    {
+        release( frame );
+        return 0;
+    }
+
+    return frame;
+}
+
+void
+EncoderPool::release( ImageFrame* frame )
+{
+    if ( !frame )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+
+        if ( isSpillFrame( frame ) )
+            mSpillFree.push_back( frame );
+        else
+        {
+            if ( mBudget )
+                mBudget->release( frame->dataSize );
+
+            mFree.push_back( frame );
+        }
+    }
+
+    mFreeCond.notify_one();
+}
+
+void
+EncoderPool::submit( ImageFrame* frame )
+{
+    if ( !frame )
+        return;
+
+    frame->tSubmit = monotonicNs();
+
+    if ( isSpillFrame( frame ) )
+    {
+        bool queued = false;
+
+        {
+            std::lock_guard<std::mutex> lock( mMutex );
+
+            if ( mSpillThread.joinable() && !mSpillStop )
+            {
+                mSpillQueue.push_back( frame );
+                queued = true;
+            }
+        }
+
+        // the spill thread has already terminated, so the frame is written right here
+        if ( queued )
+            mSpillCond.notify_one();
+        else
+            spill( frame );
+
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mQueue.push_back( frame );
+    }
+
+    if ( mWorkers )
+        mWorkers->notify();
+    else
+        mQueueCond.notify_one();
+}
+
+bool
+EncoderPool::isSpillFrame( const ImageFrame* frame ) const
+{
+    return ( frame >= &mSpillFrames[ 0 ] ) && ( frame < &mSpillFrames[ 0 ] + mSpillFrames.size() );
+}
+
+void
+EncoderPool::runSpill()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    while ( 1 )
+    {
+        while ( mSpillQueue.empty() && !mSpillStop )
+            mSpillCond.wait( lock );
+
+        // all queued spill frames are written before the thread terminates
+        if ( mSpillQueue.empty() )
+            break;
+
+        ImageFrame* frame = mSpillQueue.front();
+        mSpillQueue.pop_front();
+
+        lock.unlock();
+
+        spill( frame );
+
+        lock.lock();
+    }
+}
+
+void
+EncoderPool::spill( ImageFrame* frame )
+{
+    if ( !mNoSpillFiles && mkdir( mSpillDir.c_str(), 0755 ) && ( errno != EEXIST ) )
+        FWLOG_ERROR( "EncoderPool::spill: cannot create directory %s\n", mSpillDir.c_str() );
+
+    char name[ 32 ];
+    snprintf( name, sizeof( name ), "/spill_%06u.raw", mNoSpillFiles++ );
+
+    std::string fileName = mSpillDir + name;
+    FILE*       fp       = fopen( fileName.c_str(), "wb" );
+    bool        ok       = false;
+
+    if ( fp )
+    {
+        // the frame is stored as is, its pointers are replaced when it is read back
+        ok = ( fwrite( frame, sizeof( ImageFrame ), 1, fp ) == 1 ) &&
+             ( fwrite( frame->data, 1, frame->dataSize, fp ) == frame->dataSize );
+
+        if ( fclose( fp ) || !ok )
+        {
+            FWLOG_RATE( LOG_LEVEL_ERROR, 1000, "EncoderPool::spill: failed to write %s\n", fileName.c_str() );
+            unlink( fileName.c_str() );
+            ok = false;
+        }
+    }
+    else
+        FWLOG_RATE( LOG_LEVEL_ERROR, 1000, "EncoderPool::spill: fopen(): %s\n", strerror( errno ) );
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+
+        if ( ok )
+        {
+            mSpilled.push_back( fileName );
+            mSpillOutputDir = frame->outputDir;
+            mNoSpilled++;
+        }
+
+        mSpillFree.push_back( frame );
+    }
+
+    mFreeCond.notify_one();
+
+    if ( !ok )
+        return;
+
+    if ( mWorkers )
+        mWorkers->notify();
+    else
+        mQueueCond.notify_one();
+}
+
+void
+EncoderPool::unspill( std::unique_lock<std::mutex> & lock )
+{
+    std::string fileName  = mSpilled.front();
+    const char* outputDir = mSpillOutputDir;
+
+    mSpilled.pop_front();
+    mNoActive++;
+
+    lock.unlock();
+
+    ImageFrame frame;
+    bool       ok = false;
+    FILE*      fp = fopen( fileName.c_str(), "rb" );
+
+    if ( fp && ( fread( &frame, sizeof( ImageFrame ), 1, fp ) == 1 ) )
+    {
+        frame.data      = ( char* ) malloc( frame.dataSize );
+        frame.capacity  = frame.dataSize;
+        frame.outputDir = outputDir;
+
+        ok = frame.data && ( fread( frame.data, 1, frame.dataSize, fp ) == frame.dataSize );
+    }
+
+    if ( fp )
+        fclose( fp );
+
+    if ( ok )
+    {
+        frame.tStart = monotonicNs();
+
+        mEncode( &frame );
+
+        free( frame.data );
+        unlink( fileName.c_str() );
+    }
+    else
+        FWLOG_ERROR( "EncoderPool::unspill: failed to read %s, it is left for manual recovery\n", fileName.c_str() );
+
+    lock.lock();
+
+    mNoActive--;
+
+    if ( ok )
+        mNoUnspilled++;
+}
+
+bool
+EncoderPool::encodeNext( std::unique_lock<std::mutex> & lock )
+{
+    // shared workers leave the pending frames of a busy pool to the other pools; the worker
+    // finishing a frame of this pool looks at all pools again, so the frames are not left behind
+    if ( mWorkers && ( mNoActive >= mMaxActive ) )
+        return false;
+
+    // spilled frames are encoded when no frame waits in memory
+    if ( mQueue.empty() )
+    {
+        if ( mSpilled.empty() )
+            return false;
+
+        unspill( lock );
+        return true;
+    }
+
+    ImageFrame* frame = mQueue.front();
+    mQueue.pop_front();
+    mNoActive++;
+
+    lock.unlock();
+
+    uint64_t tStart = monotonicNs();
+
+    frame->tStart = tStart;
+
+    mEncode( frame );
+
+    uint64_t tEnd = monotonicNs();
+
+    lock.lock();
+
+    mQueueStats.add( tStart - frame->tSubmit );
+    mEncodeStats.add( tEnd - tStart );
+
+    if ( mBudget )
+        mBudget->release( frame->dataSize );
+
+    mNoActive--;
+    mFree.push_back( frame );
+    mFreeCond.notify_one();
+
+    return true;
+}
+
+bool
+EncoderPool::encodeOne()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    return encodeNext( lock );
+}
+
+void
+EncoderPool::run()
+{
+    std::unique_lock<std::mutex> lock( mMutex );
+
+    while ( 1 )
+    {
+        while ( mQueue.empty() && mSpilled.empty() && !mStop )
+            mQueueCond.wait( lock );
+
+        // all pending frames are encoded before the worker terminates
+        if ( !encodeNext( lock ) )
+            break;
+    }
+}
+
+void
+EncoderPool::printStats( const char* label, bool reset )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    char text[256];
+
+    snprintf( text, sizeof( text ), "%s: queue time", label );
+    mQueueStats.print( text, reset );
+
+    snprintf( text, sizeof( text ), "%s: encode time", label );
+    mEncodeStats.print( text, reset );
+
+    if ( mPolicy == BACKPRESSURE_BLOCK )
+    {
+        snprintf( text, sizeof( text ), "%s: reader blocked %u times, wait time", label, mNoBlocked );
+        mBlockStats.print( text, reset );
+    }
+
+    if ( ( mPolicy == BACKPRESSURE_DROP_OLDEST ) || ( mPolicy == BACKPRESSURE_KEEP_LATEST ) )
+        fprintf( stderr, "%s: %u frames replaced by newer ones before encoding\n", label, mNoReplaced );
+
+    if ( mPolicy == BACKPRESSURE_SPILL )
+    {
+        snprintf( text, sizeof( text ), "%s: reader waited %u times for a spill frame, wait time", label, mNoBlocked );
+        mBlockStats.print( text, reset );
+
+        fprintf( stderr, "%s: %u frames spilled to %s, %u of them encoded, %lu waiting\n",
+                         label, mNoSpilled, mSpillDir.c_str(), mNoUnspilled, ( unsigned long ) mSpilled.size() );
+    }
+}
+
+EncoderWorkers::EncoderWorkers() : mNoPools( 0 ),
+                                   mNoThreads( 0 ),
+                                   mStop( false ),
+                                   mSeq( 0 ),
+                                   mNoSleeping( 0 ),
+                                   mNoEncoded( 0 ),
+                                   mNoStolen( 0 ),
+                                   mHasCpus( false )
+{
+}
+
+EncoderWorkers::~EncoderWorkers()
+{
+    stop();
+}
+
+void
+EncoderWorkers::setAffinity( const cpu_set_t* cpus )
+{
+    mHasCpus = ( cpus != 0 );
+
+    if ( cpus )
+        mCpus = *cpus;
+}
+
+bool
+EncoderWorkers::start( unsigned int noThreads )
+{
+    if ( !noThreads || !mThreads.empty() )
+        return false;
+
+    mStop      = false;
+    mNoThreads = noThreads;
+
+    for ( unsigned int i = 0; i < noThreads; i++ )
+    {
+        mThreads.push_back( std::thread( &EncoderWorkers::run, this, i ) );
+
+        setThreadNormal( mThreads.back().native_handle() );
+
+        if ( mHasCpus )
+            setThreadAffinity( mThreads.back().native_handle(), mCpus );
+    }
+
+    return true;
+}
+
+void
+EncoderWorkers::stop()
+{
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+        mStop = true;
+    }
+
+    mCond.notify_all();
+
+    for ( size_t i = 0; i < mThreads.size(); i++ )
+        mThreads[ i ].join();
+
+    mThreads.clear();
+}
+
+bool
+EncoderWorkers::isRunning() const
+{
+    return !mThreads.empty() && !mStop;
+}
+
+bool
+EncoderWorkers::attach( EncoderPool* pool )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    unsigned int noPools = mNoPools.load();
+
+    if ( noPools >= MAX_POOLS )
+    {
+        FWLOG_ERROR( "EncoderWorkers::attach: no more than %u pools may be attached\n", MAX_POOLS );
+        return false;
+    }
+
+    // the workers read the table without locking, the slot is published by the count
+    mPools[ noPools ] = pool;
+    mNoPools.store( noPools + 1 );
+
+    return true;
+}
+
+void
+EncoderWorkers::notify()
+{
+    mSeq.fetch_add( 1 );
+
+    // a worker about to sleep has either registered or will see the new sequence number
+    if ( !mNoSleeping.load() )
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock( mMutex );
+    }
+
+    mCond.notify_one();
+}
+
+void
+EncoderWorkers::run( unsigned int index )
+{
+    unsigned int victim = index;
+
+    while ( 1 )
+    {
+        uint64_t     seq      = mSeq.load();
+        unsigned int noPools  = mNoPools.load();
+        unsigned int noFrames = 0;
+
+        // each pool is in the charge of one worker, which takes a frame of each of its pools in turn
+        for ( unsigned int i = index; i < noPools; i += mNoThreads )
+            noFrames += mPools[ i ]->encodeOne();
+
+        // with nothing to do, a single frame is stolen from another pool, continuing where the last theft left off
+        for ( unsigned int n = 0; !noFrames && ( n < noPools ); n++ )
+        {
+            victim = ( victim + 1 ) % noPools;
+
+            if ( ( ( victim % mNoThreads ) != index ) && mPools[ victim ]->encodeOne() )
+            {
+                noFrames = 1;
+                mNoStolen++;
+            }
+        }
+
+        if ( noFrames )
+        {
+            mNoEncoded += noFrames;
+            continue;
+        }
+
+        // all pools have been drained
+        if ( mStop )
+            break;
+
+        std::unique_lock<std::mutex> lock( mMutex );
+
+        mNoSleeping++;
+
+        while ( ( mSeq.load() == seq ) && !mStop )
+            mCond.wait( lock );
+
+        mNoSleeping--;
+    }
+}
+
+void
+EncoderWorkers::printStats( const char* label )
+{
+    unsigned int noEncoded = mNoEncoded.load();
+    unsigned int noStolen  = mNoStolen.load();
+
+    fprintf( stderr, "%s: %u shared encoder threads, %u pools, %u frames encoded, %u of them (%.1f%%) taken from the pools of other threads\n",
+                     label, mNoThreads, mNoPools.load(), noEncoded, noStolen, noEncoded ? 100.0 * noStolen / noEncoded : 0.0 );
+}
+
+} // namespace Framework
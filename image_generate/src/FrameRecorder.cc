@@ -0,0 +1,482 @@
+/* ===================================================
+ *  file:       FrameRecorder.cc
+ * ---------------------------------------------------
+ *  purpose:	append-only recording of raw RDB messages
+ *              into memory mapped segment files and
+ *              reading of such recordings
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "FrameRecorder.hh"
+#include "StreamCopy.hh"
+
+namespace Framework
+{
+
+FrameRecorder::FrameRecorder() : mSegmentSize( 0 ),
+                                 mIndex( 0 ),
+                                 mSegmentFd( -1 ),
+                                 mSegment( 0 ),
+                                 mMappedSize( 0 ),
+                                 mUsed( 0 ),
+                                 mSegmentNo( 0 ),
+                                 mNoMessages( 0 ),
+                                 mNoImages( 0 ),
+                                 mNoBytes( 0 )
+{
+}
+
+FrameRecorder::~FrameRecorder()
+{
+    close();
+}
+
+bool
+FrameRecorder::open( const std::string & name, size_t segmentSize )
+{
+    if ( mIndex )
+    {
+        fprintf( stderr, "FrameRecorder::open: recording %s is still open\n", mName.c_str() );
+        return false;
+    }
+
+    std::string indexName = name + ".rdbidx";
+
+    if ( !( mIndex = fopen( indexName.c_str(), "wb" ) ) )
+    {
+        perror( "FrameRecorder::open: fopen()" );
+        return false;
+    }
+
+    RDB_REC_INDEX_HDR_t hdr;
+    memset( &hdr, 0, sizeof( hdr ) );
+
+    hdr.magicNo    = RDB_REC_MAGIC_NO;
+    hdr.version    = RDB_REC_VERSION;
+    hdr.headerSize = sizeof( RDB_REC_INDEX_HDR_t );
+    hdr.recordSize = sizeof( RDB_REC_INDEX_t );
+
+    if ( fwrite( &hdr, sizeof( hdr ), 1, mIndex ) != 1 )
+    {
+        fprintf( stderr, "FrameRecorder::open: cannot write %s\n", indexName.c_str() );
+        fclose( mIndex );
+        mIndex = 0;
+        return false;
+    }
+
+    mName        = name;
+    mSegmentSize = segmentSize;
+    mSegmentNo   = 0;
+    mNoMessages  = 0;
+    mNoImages    = 0;
+    mNoBytes     = 0;
+
+    if ( !nextSegment( 0 ) )
+    {
+        close();
+        return false;
+    }
+
+    return true;
+}
+
+void
+FrameRecorder::close()
+{
+    closeSegment();
+
+    if ( mIndex )
+        fclose( mIndex );
+
+    mIndex = 0;
+}
+
+bool
+FrameRecorder::isOpen() const
+{
+    return mIndex != 0;
+}
+
+bool
+FrameRecorder::nextSegment( size_t minSize )
+{
+    if ( mSegment )
+    {
+        closeSegment();
+        mSegmentNo++;
+    }
+
+    char suffix[ 32 ];
+    snprintf( suffix, sizeof( suffix ), "_%04u.rdbrec", mSegmentNo );
+
+    std::string fileName = mName + suffix;
+
+    if ( ( mSegmentFd = ::open( fileName.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644 ) ) < 0 )
+    {
+        perror( "FrameRecorder::nextSegment: open()" );
+        return false;
+    }
+
+    mMappedSize = mSegmentSize;
+
+    if ( mMappedSize < minSize + sizeof( RDB_REC_SEGMENT_HDR_t ) )
+        mMappedSize = minSize + sizeof( RDB_REC_SEGMENT_HDR_t );
+
+    // reserve the blocks now, so that recording does not fail (or stall) on a full disk later on
+    int err = posix_fallocate( mSegmentFd, 0, mMappedSize );
+
+    if ( err )
+    {
+        fprintf( stderr, "FrameRecorder::nextSegment: cannot allocate %lu bytes for %s: %s\n",
+                         ( unsigned long ) mMappedSize, fileName.c_str(), strerror( err ) );
+        ::close( mSegmentFd );
+        mSegmentFd = -1;
+        return false;
+    }
+
+    mSegment = ( char* ) mmap( 0, mMappedSize, PROT_READ | PROT_WRITE, MAP_SHARED, mSegmentFd, 0 );
+
+    if ( mSegment == MAP_FAILED )
+    {
+        perror( "FrameRecorder::nextSegment: mmap()" );
+        mSegment = 0;
+        ::close( mSegmentFd );
+        mSegmentFd = -1;
+        return false;
+    }
+
+    // pages are only written once, in ascending order
+    madvise( mSegment, mMappedSize, MADV_SEQUENTIAL );
+
+    RDB_REC_SEGMENT_HDR_t* hdr = ( RDB_REC_SEGMENT_HDR_t* ) mSegment;
+
+    hdr->magicNo    = RDB_REC_MAGIC_NO;
+    hdr->version    = RDB_REC_VERSION;
+    hdr->headerSize = sizeof( RDB_REC_SEGMENT_HDR_t );
+    hdr->segmentNo  = mSegmentNo;
+    hdr->spare0     = 0;
+    hdr->dataSize   = 0;
+
+    mUsed = sizeof( RDB_REC_SEGMENT_HDR_t );
+
+    return true;
+}
+
+void
+FrameRecorder::closeSegment()
+{
+    if ( !mSegment )
+        return;
+
+    ( ( RDB_REC_SEGMENT_HDR_t* ) mSegment )->dataSize = mUsed - sizeof( RDB_REC_SEGMENT_HDR_t );
+
+    // write-back is left to the kernel; only the unused preallocated tail is given back
+    munmap( mSegment, mMappedSize );
+
+    if ( ftruncate( mSegmentFd, mUsed ) )
+        perror( "FrameRecorder::closeSegment: ftruncate()" );
+
+    ::close( mSegmentFd );
+
+    mSegment    = 0;
+    mSegmentFd  = -1;
+    mMappedSize = 0;
+}
+
+bool
+FrameRecorder::addIndex( const RDB_MSG_t* msg, uint64_t msgOffset, uint32_t msgSize, uint16_t cameraId, uint32_t imgOffset )
+{
+    RDB_REC_INDEX_t rec;
+
+    rec.frameNo   = msg->hdr.frameNo;
+    rec.cameraId  = cameraId;
+    rec.segmentNo = mSegmentNo;
+    rec.simTime   = msg->hdr.simTime;
+    rec.msgOffset = msgOffset;
+    rec.msgSize   = msgSize;
+    rec.imgOffset = imgOffset;
+
+    return fwrite( &rec, sizeof( rec ), 1, mIndex ) == 1;
+}
+
+bool
+FrameRecorder::record( const RDB_MSG_t* msg )
+{
+    if ( !mIndex || !msg )
+        return false;
+
+    uint32_t msgSize = msg->hdr.headerSize + msg->hdr.dataSize;
+
+    if ( ( mUsed + msgSize > mMappedSize ) && !nextSegment( msgSize ) )
+    {
+        close();
+        return false;
+    }
+
+    uint64_t msgOffset = mUsed;
+
+    // the one and only copy of the message
+    streamCopy( mSegment + mUsed, msg, msgSize );
+    mUsed += msgSize;
+
+    // index the images of the message, walking the entries of the copy
+    const char* msgPtr    = mSegment + msgOffset;
+    const char* entryPtr  = msgPtr + msg->hdr.headerSize;
+    const char* end       = entryPtr + msg->hdr.dataSize;
+    bool        ok        = true;
+    bool        haveImage = false;
+
+    while ( entryPtr + sizeof( RDB_MSG_ENTRY_HDR_t ) <= end )
+    {
+        const RDB_MSG_ENTRY_HDR_t* entry = ( const RDB_MSG_ENTRY_HDR_t* ) entryPtr;
+
+        if ( !entry->headerSize )
+            break;
+
+        if ( ( entry->pkgId == RDB_PKG_ID_IMAGE ) && entry->elementSize )
+        {
+            const char* pkg   = entryPtr + entry->headerSize;
+            uint32_t    noImg = entry->dataSize / entry->elementSize;
+
+            for ( uint32_t i = 0; i < noImg; i++, pkg += entry->elementSize )
+            {
+                ok = ok && addIndex( msg, msgOffset, msgSize, ( ( const RDB_IMAGE_t* ) pkg )->cameraId, ( uint32_t ) ( pkg - msgPtr ) );
+                mNoImages++;
+                haveImage = true;
+            }
+        }
+
+        entryPtr += entry->headerSize + entry->dataSize;
+    }
+
+    if ( !haveImage )
+        ok = ok && addIndex( msg, msgOffset, msgSize, RDB_REC_NO_CAMERA, 0 );
+
+    if ( !ok )
+    {
+        fprintf( stderr, "FrameRecorder::record: cannot write the index of %s\n", mName.c_str() );
+        close();
+        return false;
+    }
+
+    mNoMessages++;
+    mNoBytes += msgSize;
+
+    return true;
+}
+
+void
+FrameRecorder::printStats( const char* label ) const
+{
+    fprintf( stderr, "%s: recorded %llu messages with %llu images, %.1f MB in %u segments\n", label,
+                     ( unsigned long long ) mNoMessages, ( unsigned long long ) mNoImages, mNoBytes / 1048576.0, mSegmentNo + 1 );
+}
+
+RecordingReader::RecordingReader() : mNext( 0 ),
+                                     mMaxFrameSize( 0 )
+{
+}
+
+RecordingReader::~RecordingReader()
+{
+    close();
+}
+
+bool
+RecordingReader::open( const std::string & name )
+{
+    close();
+
+    std::string indexName = name + ".rdbidx";
+    FILE*       fp        = fopen( indexName.c_str(), "rb" );
+
+    if ( !fp )
+    {
+        perror( "RecordingReader::open: fopen()" );
+        return false;
+    }
+
+    RDB_REC_INDEX_HDR_t hdr;
+
+    if ( ( fread( &hdr, sizeof( hdr ), 1, fp ) != 1 ) || ( hdr.magicNo != RDB_REC_MAGIC_NO ) || ( hdr.version != RDB_REC_VERSION ) ||
+         ( hdr.headerSize != sizeof( RDB_REC_INDEX_HDR_t ) ) || ( hdr.recordSize != sizeof( RDB_REC_INDEX_t ) ) )
+    {
+        fprintf( stderr, "RecordingReader::open: %s is no recording index of version %u\n", indexName.c_str(), RDB_REC_VERSION );
+        fclose( fp );
+        return false;
+    }
+
+    mName = name;
+
+    RDB_REC_INDEX_t rec;
+    uint32_t        frameNo   = 0;
+    size_t          frameSize = 0;
+
+    while ( fread( &rec, sizeof( rec ), 1, fp ) == 1 )
+    {
+        // a message with several images has one record per image
+        if ( !mMessages.empty() && ( mMessages.back().segmentNo == rec.segmentNo ) && ( mMessages.back().msgOffset == rec.msgOffset ) )
+            continue;
+
+        if ( ( rec.segmentNo >= mSegments.size() ) && !mapSegment( rec.segmentNo ) )
+        {
+            fclose( fp );
+            close();
+            return false;
+        }
+
+        const RDB_MSG_t* msg = ( const RDB_MSG_t* ) ( mSegments[ rec.segmentNo ] + rec.msgOffset );
+
+        if ( ( rec.msgOffset + rec.msgSize > mSegmentSizes[ rec.segmentNo ] ) || ( msg->hdr.magicNo != RDB_MAGIC_NO ) )
+        {
+            fprintf( stderr, "RecordingReader::open: invalid message at offset %llu of segment %u, recording is cut off here\n",
+                             ( unsigned long long ) rec.msgOffset, rec.segmentNo );
+            break;
+        }
+
+        if ( mMessages.empty() || ( rec.frameNo != frameNo ) )
+            frameSize = 0;
+
+        frameNo    = rec.frameNo;
+        frameSize += rec.msgSize;
+
+        if ( frameSize > mMaxFrameSize )
+            mMaxFrameSize = frameSize;
+
+        mMessages.push_back( rec );
+    }
+
+    fclose( fp );
+
+    return true;
+}
+
+bool
+RecordingReader::mapSegment( unsigned int segmentNo )
+{
+    // segments are mapped in ascending order, they are referenced by the index in that order
+    while ( mSegments.size() <= segmentNo )
+    {
+        char suffix[ 32 ];
+        snprintf( suffix, sizeof( suffix ), "_%04u.rdbrec", ( unsigned int ) mSegments.size() );
+
+        std::string fileName = mName + suffix;
+        int         fd       = ::open( fileName.c_str(), O_RDONLY );
+        struct stat st;
+
+        if ( fd < 0 )
+        {
+            perror( "RecordingReader::mapSegment: open()" );
+            return false;
+        }
+
+        if ( fstat( fd, &st ) || ( ( size_t ) st.st_size < sizeof( RDB_REC_SEGMENT_HDR_t ) ) )
+        {
+            fprintf( stderr, "RecordingReader::mapSegment: %s is too short\n", fileName.c_str() );
+            ::close( fd );
+            return false;
+        }
+
+        char* segment = ( char* ) mmap( 0, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0 );
+
+        ::close( fd );
+
+        if ( segment == MAP_FAILED )
+        {
+            perror( "RecordingReader::mapSegment: mmap()" );
+            return false;
+        }
+
+        // messages are read once, in ascending order
+        madvise( segment, st.st_size, MADV_SEQUENTIAL );
+
+        mSegments.push_back( segment );
+        mSegmentSizes.push_back( st.st_size );
+
+        const RDB_REC_SEGMENT_HDR_t* hdr = ( const RDB_REC_SEGMENT_HDR_t* ) segment;
+
+        if ( ( hdr->magicNo != RDB_REC_MAGIC_NO ) || ( hdr->version != RDB_REC_VERSION ) || ( hdr->segmentNo != mSegments.size() - 1 ) )
+        {
+            fprintf( stderr, "RecordingReader::mapSegment: %s is no segment of version %u\n", fileName.c_str(), RDB_REC_VERSION );
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void
+RecordingReader::close()
+{
+    for ( size_t i = 0; i < mSegments.size(); i++ )
+        munmap( mSegments[ i ], mSegmentSizes[ i ] );
+
+    mSegments.clear();
+    mSegmentSizes.clear();
+    mMessages.clear();
+    mName.clear();
+
+    mNext         = 0;
+    mMaxFrameSize = 0;
+}
+
+bool
+RecordingReader::isOpen() const
+{
+    return !mName.empty();
+}
+
+bool
+RecordingReader::nextFrame( std::vector<const RDB_MSG_t*> & msgs )
+{
+    msgs.clear();
+
+    if ( mNext >= mMessages.size() )
+        return false;
+
+    uint32_t frameNo = mMessages[ mNext ].frameNo;
+
+    while ( ( mNext < mMessages.size() ) && ( mMessages[ mNext ].frameNo == frameNo ) )
+    {
+        const RDB_REC_INDEX_t & rec = mMessages[ mNext++ ];
+
+        msgs.push_back( ( const RDB_MSG_t* ) ( mSegments[ rec.segmentNo ] + rec.msgOffset ) );
+    }
+
+    return true;
+}
+
+void
+RecordingReader::rewind()
+{
+    mNext = 0;
+}
+
+size_t
+RecordingReader::getNoMessages() const
+{
+    return mMessages.size();
+}
+
+size_t
+RecordingReader::getMaxFrameSize() const
+{
+    return mMaxFrameSize;
+}
+
+void
+RecordingReader::getFrameRange( uint32_t & first, uint32_t & last ) const
+{
+    first = mMessages.empty() ? 0 : mMessages.front().frameNo;
+    last  = mMessages.empty() ? 0 : mMessages.back().frameNo;
+}
+
+} // namespace Framework
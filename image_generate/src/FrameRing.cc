@@ -0,0 +1,327 @@
+/* ===================================================
+ *  file:       FrameRing.cc
+ * ---------------------------------------------------
+ *  purpose:	ring of decoded frames in POSIX shared
+ *              memory, published by the reader for any
+ *              number of local consumer processes
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "FrameRing.hh"
+#include "ShmNotify.hh"
+#include "AsyncLog.hh"
+
+/* ====== DEFINITIONS ====== */
+#define FRAME_RING_ROUND_UP( size )  ( ( ( size ) + FRAME_RING_ALIGN - 1 ) & ~( ( size_t ) FRAME_RING_ALIGN - 1 ) )
+#define FRAME_RING_PID_CHECK_NS      100000000ull      // interval of checking whether the producer process still exists @unit ns
+
+namespace Framework
+{
+
+FrameRing::FrameRing() : mHdr( 0 ),
+                         mSize( 0 ),
+                         mOwner( false ),
+                         mNoTooLarge( 0 ),
+                         mTPidCheck( 0 )
+{
+}
+
+FrameRing::~FrameRing()
+{
+    close();
+}
+
+bool
+FrameRing::create( const std::string & name, unsigned int noSlots, size_t maxDataSize )
+{
+    if ( mHdr || !noSlots || !maxDataSize )
+        return false;
+
+    size_t hdrSize  = FRAME_RING_ROUND_UP( sizeof( FRAME_RING_HDR_t ) );
+    size_t slotSize = FRAME_RING_ROUND_UP( sizeof( FRAME_RING_SLOT_t ) ) + FRAME_RING_ROUND_UP( maxDataSize );
+
+    if ( slotSize > 0xffffffffu )
+    {
+        fprintf( stderr, "FrameRing::create: slots of %lu bytes are too large\n", ( unsigned long ) slotSize );
+        return false;
+    }
+
+    // consumers of a ring left behind keep their mapping of the old object, so it is marked closed
+    int fd = shm_open( name.c_str(), O_RDWR, 0 );
+
+    if ( fd >= 0 )
+    {
+        struct stat st;
+
+        if ( ( fstat( fd, &st ) == 0 ) && ( st.st_size >= ( off_t ) sizeof( FRAME_RING_HDR_t ) ) )
+        {
+            void* ptr = mmap( 0, sizeof( FRAME_RING_HDR_t ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+            if ( ptr != MAP_FAILED )
+            {
+                __atomic_store_n( &( ( FRAME_RING_HDR_t* ) ptr )->magicNo, 0, __ATOMIC_RELEASE );
+                munmap( ptr, sizeof( FRAME_RING_HDR_t ) );
+            }
+        }
+
+        ::close( fd );
+        shm_unlink( name.c_str() );
+    }
+
+    fd = shm_open( name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0666 );
+
+    if ( fd < 0 )
+    {
+        perror( "FrameRing::create: shm_open()" );
+        return false;
+    }
+
+    // the pages are only backed by memory once a frame has been written to them
+    mSize = hdrSize + slotSize * noSlots;
+
+    if ( ftruncate( fd, mSize ) < 0 )
+    {
+        perror( "FrameRing::create: ftruncate()" );
+        ::close( fd );
+        shm_unlink( name.c_str() );
+        return false;
+    }
+
+    void* ptr = mmap( 0, mSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    ::close( fd );
+
+    if ( ptr == MAP_FAILED )
+    {
+        perror( "FrameRing::create: mmap()" );
+        shm_unlink( name.c_str() );
+        return false;
+    }
+
+    mHdr   = ( FRAME_RING_HDR_t* ) ptr;
+    mOwner = true;
+    mName  = name;
+
+    mHdr->version     = FRAME_RING_VERSION;
+    mHdr->hdrSize     = hdrSize;
+    mHdr->noSlots     = noSlots;
+    mHdr->slotSize    = slotSize;
+    mHdr->maxDataSize = FRAME_RING_ROUND_UP( maxDataSize );
+    mHdr->pid         = getpid();
+
+    // consumers look at nothing else before the magic number is there
+    __atomic_store_n( &mHdr->magicNo, ( uint32_t ) FRAME_RING_MAGIC_NO, __ATOMIC_RELEASE );
+
+    return true;
+}
+
+bool
+FrameRing::open( const std::string & name )
+{
+    if ( mHdr )
+        return true;
+
+    int fd = shm_open( name.c_str(), O_RDONLY, 0 );
+
+    if ( fd < 0 )
+        return false;
+
+    struct stat st;
+    void*       ptr = MAP_FAILED;
+
+    if ( ( fstat( fd, &st ) == 0 ) && ( st.st_size >= ( off_t ) sizeof( FRAME_RING_HDR_t ) ) )
+        ptr = mmap( 0, st.st_size, PROT_READ, MAP_SHARED, fd, 0 );
+
+    ::close( fd );
+
+    if ( ptr == MAP_FAILED )
+        return false;
+
+    FRAME_RING_HDR_t* hdr = ( FRAME_RING_HDR_t* ) ptr;
+
+    // the object may have been created, but not yet initialized, or been left behind by a producer which has been killed
+    if ( ( __atomic_load_n( &hdr->magicNo, __ATOMIC_ACQUIRE ) != FRAME_RING_MAGIC_NO ) || ( hdr->version != FRAME_RING_VERSION ) ||
+         ( ( off_t ) ( hdr->hdrSize + ( uint64_t ) hdr->slotSize * hdr->noSlots ) > st.st_size ) || !producerExists( hdr->pid ) )
+    {
+        munmap( ptr, st.st_size );
+        return false;
+    }
+
+    mHdr       = hdr;
+    mSize      = st.st_size;
+    mOwner     = false;
+    mName      = name;
+    mTPidCheck = monotonicNs();
+
+    return true;
+}
+
+void
+FrameRing::close()
+{
+    if ( !mHdr )
+        return;
+
+    if ( mOwner )
+    {
+        __atomic_store_n( &mHdr->magicNo, 0, __ATOMIC_RELEASE );
+        shm_unlink( mName.c_str() );
+    }
+
+    munmap( mHdr, mSize );
+
+    mHdr  = 0;
+    mSize = 0;
+}
+
+bool
+FrameRing::isOpen() const
+{
+    return mHdr != 0;
+}
+
+bool
+FrameRing::isAlive() const
+{
+    if ( !mHdr || ( __atomic_load_n( &mHdr->magicNo, __ATOMIC_ACQUIRE ) != FRAME_RING_MAGIC_NO ) )
+        return false;
+
+    if ( mOwner )
+        return true;
+
+    // a producer killed by SIGKILL cannot mark the ring closed; the check costs a syscall, so it is done now and then only
+    uint64_t tNow = monotonicNs();
+
+    if ( tNow - mTPidCheck < FRAME_RING_PID_CHECK_NS )
+        return true;
+
+    // once the producer is gone, it is checked again on every call, so that the ring remains dead
+    if ( !producerExists( mHdr->pid ) )
+        return false;
+
+    mTPidCheck = tNow;
+
+    return true;
+}
+
+bool
+FrameRing::producerExists( uint32_t pid )
+{
+    // a process of another user exists as well, only ESRCH tells that it is gone
+    return ( kill( ( pid_t ) pid, 0 ) == 0 ) || ( errno != ESRCH );
+}
+
+FRAME_RING_SLOT_t*
+FrameRing::getSlot( uint64_t index ) const
+{
+    return ( FRAME_RING_SLOT_t* ) ( ( char* ) mHdr + mHdr->hdrSize + ( size_t ) mHdr->slotSize * ( index % mHdr->noSlots ) );
+}
+
+char*
+FrameRing::getData( FRAME_RING_SLOT_t* slot )
+{
+    return ( char* ) slot + FRAME_RING_ROUND_UP( sizeof( FRAME_RING_SLOT_t ) );
+}
+
+const char*
+FrameRing::getData( const FRAME_RING_SLOT_t* slot )
+{
+    return ( const char* ) slot + FRAME_RING_ROUND_UP( sizeof( FRAME_RING_SLOT_t ) );
+}
+
+FRAME_RING_SLOT_t*
+FrameRing::beginWrite( size_t dataSize )
+{
+    if ( !mHdr || !mOwner )
+        return 0;
+
+    if ( dataSize > mHdr->maxDataSize )
+    {
+        mNoTooLarge++;
+        FWLOG_RATE( LOG_LEVEL_WARN, 5000, "FrameRing::beginWrite: frame of %lu bytes does not fit into the slots of %u bytes, not published\n",
+                    ( unsigned long ) dataSize, mHdr->maxDataSize );
+        return 0;
+    }
+
+    // the producer is the only writer, so the count needs no atomic increment
+    uint64_t           frameNo = mHdr->noPublished;
+    FRAME_RING_SLOT_t* slot    = getSlot( frameNo );
+    uint32_t           seq     = slot->seq;
+
+    // an odd sequence tells the readers that the slot is changing; the contents must not be written before it
+    __atomic_store_n( &slot->seq, seq + 1, __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+
+    slot->frameNo  = frameNo;
+    slot->dataSize = dataSize;
+
+    return slot;
+}
+
+void
+FrameRing::endWrite( FRAME_RING_SLOT_t* slot )
+{
+    if ( !slot )
+        return;
+
+    slot->tPublish = monotonicNs();
+
+    __atomic_store_n( &slot->seq, slot->seq + 1, __ATOMIC_RELEASE );
+    __atomic_store_n( &mHdr->noPublished, slot->frameNo + 1, __ATOMIC_RELEASE );
+}
+
+uint64_t
+FrameRing::getNoPublished() const
+{
+    return mHdr ? __atomic_load_n( &mHdr->noPublished, __ATOMIC_ACQUIRE ) : 0;
+}
+
+const FRAME_RING_SLOT_t*
+FrameRing::peek( uint64_t frameNo, uint32_t & version ) const
+{
+    if ( !mHdr )
+        return 0;
+
+    const FRAME_RING_SLOT_t* slot = getSlot( frameNo );
+
+    version = __atomic_load_n( &slot->seq, __ATOMIC_ACQUIRE );
+
+    if ( ( version & 1 ) || ( slot->frameNo != frameNo ) )
+        return 0;
+
+    return slot;
+}
+
+bool
+FrameRing::check( const FRAME_RING_SLOT_t* slot, uint32_t version ) const
+{
+    // the reads of the slot must be done before the sequence is read again
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+    return __atomic_load_n( &slot->seq, __ATOMIC_RELAXED ) == version;
+}
+
+unsigned int
+FrameRing::getNoSlots() const
+{
+    return mHdr ? mHdr->noSlots : 0;
+}
+
+unsigned int
+FrameRing::getNoTooLarge() const
+{
+    return mNoTooLarge;
+}
+
+} // namespace Framework
@@ -0,0 +1,227 @@
+// FrameRingReader.cpp : sample consumer of the frame ring published by
+// image_generate -n, using the frames in place without copying them
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include "FrameRing.hh"
+#include "ShmNotify.hh"
+
+// forward declarations of methods
+
+/**
+* check whether a frame has been published which has not been read yet
+* @param userData   unused
+* @return true if there is a new frame
+*/
+bool ringHasData( void* userData );
+
+/**
+* read a frame in place
+* @param frameNo    index of the frame
+* @return true if a frame has been read
+*/
+bool readFrame( uint64_t frameNo );
+
+/**
+* some global variables, considered "members" of this program
+*/
+std::string               mRingName     = "/image_frames";      // name of the frame ring
+int                       mCameraId     = -1;                   // camera to be read, -1 = all
+bool                      mLatestOnly   = false;                // skip to the latest frame instead of reading every frame?
+bool                      mVerbose      = false;                // run in verbose mode?
+volatile sig_atomic_t     mQuit         = 0;                    // set by the signal handler
+
+Framework::FrameRing      mRing;                                // the frame ring
+Framework::AdaptiveWaiter mWaiter;                              // waiting for the next frame
+Framework::TimingStats    mPublishStats;                        // time from publishing to reading a frame
+Framework::TimingStats    mReadyStats;                          // time from the handover of the IG's SHM buffer to reading a frame
+uint64_t                  mNextFrame    = 0;                    // index of the next frame to be read
+uint64_t                  mNoRead       = 0;                    // number of frames read
+uint64_t                  mNoLapped     = 0;                    // number of frames overwritten before they could be read
+uint64_t                  mNoTorn       = 0;                    // number of frames overwritten while being read
+uint64_t                  mChecksum     = 0;                    // sum over the data read, stands for the work of a consumer
+
+/**
+* information about usage of the software
+* this method will exit the program
+*/
+void usage()
+{
+    printf("usage: frameRingReader [-n:ring] [-i:cameraId] [-l] [-v]\n\n");
+    printf("       -n:ring       name of the frame ring published by image_generate -n (default /image_frames)\n");
+    printf("       -i:cameraId   read the frames of a single camera only (default: all)\n");
+    printf("       -l            latest only: skip to the latest frame instead of reading every frame (preview)\n");
+    printf("       -v            run in verbose mode\n");
+    exit(1);
+}
+
+/**
+* validate the arguments given in the command line
+*/
+void ValidateArgs(int argc, char **argv)
+{
+    for( int i = 1; i < argc; i++)
+    {
+        if ((argv[i][0] == '-') || (argv[i][0] == '/'))
+        {
+            switch (tolower(argv[i][1]))
+            {
+                case 'n':       // name of the ring
+                    if ( strlen( argv[i] ) > 3 )
+                        mRingName = &argv[i][3];
+                    if ( mRingName[ 0 ] != '/' )
+                        mRingName = "/" + mRingName;
+                    break;
+
+                case 'i':       // camera
+                    if ( strlen( argv[i] ) > 3 )
+                        mCameraId = strtoul( &argv[i][3], 0, 0 );
+                    break;
+
+                case 'l':       // latest only
+                    mLatestOnly = true;
+                    break;
+
+                case 'v':       // verbose mode
+                    mVerbose = true;
+                    break;
+
+                default:
+                    usage();
+                    break;
+            }
+        }
+    }
+}
+
+/**
+* stop reading on SIGINT / SIGTERM so that statistics can be printed
+*/
+void sigHandler( int )
+{
+    mQuit = 1;
+}
+
+int main(int argc, char* argv[])
+{
+    ValidateArgs(argc, argv);
+
+    signal( SIGINT,  sigHandler );
+    signal( SIGTERM, sigHandler );
+
+    uint64_t tLastPrint = Framework::monotonicNs();
+
+    while ( !mQuit )
+    {
+        // the ring is created by image_generate, which may be started later or restarted
+        if ( !mRing.isAlive() )
+        {
+            mRing.close();
+
+            if ( !mRing.open( mRingName ) )
+            {
+                usleep( 100000 );
+                continue;
+            }
+
+            // frames published before are not of interest
+            mNextFrame = mRing.getNoPublished();
+
+            fprintf( stderr, "FrameRingReader: opened %s, %u slots\n", mRingName.c_str(), mRing.getNoSlots() );
+        }
+
+        if ( !mWaiter.wait( ringHasData, 0, 100000 ) )
+            continue;
+
+        uint64_t noPublished = mRing.getNoPublished();
+
+        // the producer never waits, so a slow consumer loses the frames it has been lapped by
+        if ( mLatestOnly )
+        {
+            if ( noPublished )
+                mNextFrame = noPublished - 1;
+        }
+        else if ( noPublished - mNextFrame > mRing.getNoSlots() )
+        {
+            mNoLapped  += noPublished - mNextFrame - mRing.getNoSlots();
+            mNextFrame  = noPublished - mRing.getNoSlots();
+        }
+
+        while ( ( mNextFrame < noPublished ) && !mQuit )
+            readFrame( mNextFrame++ );
+
+        uint64_t tNow = Framework::monotonicNs();
+
+        if ( mVerbose && ( tNow - tLastPrint >= 1000000000ull ) )
+        {
+            fprintf( stderr, "FrameRingReader: %lu frames read, %lu lapped, %lu torn\n",
+                             ( unsigned long ) mNoRead, ( unsigned long ) mNoLapped, ( unsigned long ) mNoTorn );
+            tLastPrint = tNow;
+        }
+    }
+
+    mPublishStats.print( "FrameRingReader: time from publishing to reading" );
+    mReadyStats.print( "FrameRingReader: time from the SHM handover to reading" );
+
+    fprintf( stderr, "FrameRingReader: %lu frames read, %lu lapped (overwritten before being read), %lu torn (overwritten while being read), checksum 0x%lx\n",
+                     ( unsigned long ) mNoRead, ( unsigned long ) mNoLapped, ( unsigned long ) mNoTorn, ( unsigned long ) mChecksum );
+
+    return 0;
+}
+
+bool ringHasData( void* )
+{
+    return mQuit || !mRing.isAlive() || ( mRing.getNoPublished() != mNextFrame );
+}
+
+bool readFrame( uint64_t frameNo )
+{
+    uint32_t                           version;
+    const Framework::FRAME_RING_SLOT_t* slot = mRing.peek( frameNo, version );
+
+    if ( !slot )
+    {
+        mNoLapped++;
+        return false;
+    }
+
+    if ( ( mCameraId >= 0 ) && ( slot->info.cameraId != mCameraId ) )
+        return false;
+
+    // the data is used right in the ring; a real consumer would display or label it here
+    const uint64_t* data = ( const uint64_t* ) Framework::FrameRing::getData( slot );
+    uint64_t        sum  = 0;
+
+    for ( size_t i = 0; i < slot->dataSize / sizeof( uint64_t ); i++ )
+        sum += data[ i ];
+
+    uint64_t tRead    = Framework::monotonicNs();
+    uint64_t tPublish = slot->tPublish;
+    uint64_t tReady   = slot->tReady;
+
+    if ( mVerbose )
+        fprintf( stderr, "FrameRingReader: frame %lu, SHM 0x%x, camera %hu, simFrame %u, %u x %u, %u bytes\n",
+                         ( unsigned long ) frameNo, slot->shmKey, slot->info.cameraId, slot->simFrame, slot->width, slot->height, slot->dataSize );
+
+    // whatever has been read is only valid if the producer has not started to overwrite the slot meanwhile
+    if ( !mRing.check( slot, version ) )
+    {
+        mNoTorn++;
+        return false;
+    }
+
+    mChecksum += sum;
+    mNoRead++;
+
+    mPublishStats.add( tRead - tPublish );
+
+    if ( tReady )
+        mReadyStats.add( tRead - tReady );
+
+    return true;
+}
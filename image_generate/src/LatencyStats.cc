@@ -0,0 +1,210 @@
+/* ===================================================
+ *  file:       LatencyStats.cc
+ * ---------------------------------------------------
+ *  purpose:	latency histograms of the processing
+ *              stages of a frame, filled lock-free
+ *              by the threads of the reader
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include "LatencyStats.hh"
+
+namespace Framework
+{
+
+static const char* sStageNames[ LATENCY_NO_STAGES ] =
+{
+    "detect", "lock", "copy", "convert", "queue", "encode", "write", "total"
+};
+
+LatencyHistogram::LatencyHistogram() : mMax( 0 )
+{
+    for ( unsigned int i = 0; i < NO_BUCKETS; i++ )
+        mCounts[ i ].store( 0, std::memory_order_relaxed );
+}
+
+unsigned int
+LatencyHistogram::bucket( uint64_t durationNs )
+{
+    if ( durationNs < NO_SUB_BUCKETS )
+        return ( unsigned int ) durationNs;
+
+    // the 4 bits below the leading one select the sub-bucket
+    unsigned int exponent = 63 - __builtin_clzll( durationNs );
+
+    return ( exponent - 3 ) * NO_SUB_BUCKETS + ( ( durationNs >> ( exponent - 4 ) ) & ( NO_SUB_BUCKETS - 1 ) );
+}
+
+uint64_t
+LatencyHistogram::upperBound( unsigned int index )
+{
+    if ( index < NO_SUB_BUCKETS )
+        return index;
+
+    unsigned int exponent = index / NO_SUB_BUCKETS + 3;
+    uint64_t     mantissa = NO_SUB_BUCKETS + index % NO_SUB_BUCKETS;
+
+    return ( ( mantissa + 1 ) << ( exponent - 4 ) ) - 1;
+}
+
+void
+LatencyHistogram::add( uint64_t durationNs )
+{
+    std::atomic<uint64_t>& count = mCounts[ bucket( durationNs ) ];
+
+    // single writer: a plain load and store keep the counter consistent for concurrent readers
+    count.store( count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+
+    if ( durationNs > mMax.load( std::memory_order_relaxed ) )
+        mMax.store( durationNs, std::memory_order_relaxed );
+}
+
+uint64_t
+LatencyHistogram::getCount( unsigned int index ) const
+{
+    return mCounts[ index ].load( std::memory_order_relaxed );
+}
+
+uint64_t
+LatencyHistogram::getMax() const
+{
+    return mMax.load( std::memory_order_relaxed );
+}
+
+LatencyStats::LatencyStats() : mPrinted( LATENCY_NO_STAGES * LatencyHistogram::NO_BUCKETS, 0 )
+{
+}
+
+LatencyStats::~LatencyStats()
+{
+    for ( size_t i = 0; i < mThreads.size(); i++ )
+        delete mThreads[ i ];
+}
+
+LatencyStats::ThreadHistograms*
+LatencyStats::local()
+{
+    static thread_local LatencyStats*     tOwner = 0;
+    static thread_local ThreadHistograms* tHist  = 0;
+
+    if ( tOwner == this )
+        return tHist;
+
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::thread::id self = std::this_thread::get_id();
+
+    tOwner = this;
+    tHist  = 0;
+
+    for ( size_t i = 0; ( i < mThreads.size() ) && !tHist; i++ )
+    {
+        if ( mThreads[ i ]->threadId == self )
+            tHist = mThreads[ i ];
+    }
+
+    if ( !tHist )
+    {
+        tHist           = new ThreadHistograms;
+        tHist->threadId = self;
+
+        mThreads.push_back( tHist );
+    }
+
+    return tHist;
+}
+
+void
+LatencyStats::add( int stage, uint64_t durationNs )
+{
+    if ( ( stage < 0 ) || ( stage >= LATENCY_NO_STAGES ) )
+        return;
+
+    local()->stages[ stage ].add( durationNs );
+}
+
+void
+LatencyStats::add( int stage, uint64_t tStart, uint64_t tEnd )
+{
+    if ( tStart && ( tEnd >= tStart ) )
+        add( stage, tEnd - tStart );
+}
+
+void
+LatencyStats::print( const char* label, bool interval )
+{
+    std::lock_guard<std::mutex> lock( mMutex );
+
+    std::vector<uint64_t> counts( LatencyHistogram::NO_BUCKETS );
+
+    for ( int stage = 0; stage < LATENCY_NO_STAGES; stage++ )
+    {
+        uint64_t  total = 0;
+        uint64_t  max   = 0;
+        uint64_t* last  = &mPrinted[ stage * LatencyHistogram::NO_BUCKETS ];
+
+        for ( unsigned int i = 0; i < LatencyHistogram::NO_BUCKETS; i++ )
+        {
+            uint64_t sum = 0;
+
+            for ( size_t t = 0; t < mThreads.size(); t++ )
+                sum += mThreads[ t ]->stages[ stage ].getCount( i );
+
+            counts[ i ] = interval ? sum - last[ i ] : sum;
+            total      += counts[ i ];
+
+            if ( interval )
+                last[ i ] = sum;
+        }
+
+        if ( !total )
+            continue;
+
+        for ( size_t t = 0; t < mThreads.size(); t++ )
+        {
+            if ( mThreads[ t ]->stages[ stage ].getMax() > max )
+                max = mThreads[ t ]->stages[ stage ].getMax();
+        }
+
+        uint64_t     rank50 = ( total + 1 ) / 2;
+        uint64_t     rank99 = total - total / 100;
+        uint64_t     seen   = 0;
+        uint64_t     p50    = 0;
+        uint64_t     p99    = 0;
+        unsigned int top    = 0;
+
+        for ( unsigned int i = 0; i < LatencyHistogram::NO_BUCKETS; i++ )
+        {
+            if ( !counts[ i ] )
+                continue;
+
+            if ( ( seen < rank50 ) && ( seen + counts[ i ] >= rank50 ) )
+                p50 = LatencyHistogram::upperBound( i );
+
+            if ( ( seen < rank99 ) && ( seen + counts[ i ] >= rank99 ) )
+                p99 = LatencyHistogram::upperBound( i );
+
+            seen += counts[ i ];
+            top   = i;
+        }
+
+        if ( interval && ( LatencyHistogram::upperBound( top ) < max ) )
+            max = LatencyHistogram::upperBound( top );
+
+        // the buckets are coarser than the exact maximum
+        if ( p50 > max )
+            p50 = max;
+
+        if ( p99 > max )
+            p99 = max;
+
+        fprintf( stderr, "%s: latency %-7s over %llu samples: p50 = %.1f us, p99 = %.1f us, max = %.1f us\n",
+                         label, sStageNames[ stage ], ( unsigned long long ) total, p50 * 1.0e-3, p99 * 1.0e-3, max * 1.0e-3 );
+    }
+}
+
+} // namespace Framework
@@ -0,0 +1,821 @@
+/* ===================================================
+ *  file:       PixelConvert.cc
+ * ---------------------------------------------------
+ *  purpose:	conversion of RDB images into the pixel
+ *              layout written by the encoders
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <string.h>
+#include <strings.h>
+#include "viRDBIcd.h"
+#include "PixelConvert.hh"
+#include "StreamCopy.hh"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define PIXEL_CONVERT_X86
+#include <immintrin.h>
+#endif
+
+namespace Framework
+{
+
+/**
+* routine converting the pixels [x, width) of a row; the scalar kernels are
+* written in this form, so that they serve as tail of the SIMD kernels
+*/
+typedef void ( *PixelSpanFunc )( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width );
+
+/**
+* row routine made of a scalar span kernel
+*/
+template <PixelSpanFunc Span>
+static void
+scalarRow( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    Span( src, dst, 0, width );
+}
+
+static inline float
+halfToFloat( uint16_t h )
+{
+    uint32_t sign = ( uint32_t ) ( h & 0x8000 ) << 16;
+    uint32_t exp  = ( h >> 10 ) & 0x1f;
+    uint32_t mant = h & 0x3ff;
+    uint32_t bits;
+
+    if ( exp == 0x1f )                  // infinity or NaN
+        bits = sign | 0x7f800000 | ( mant << 13 );
+    else if ( exp )                     // normalized
+        bits = sign | ( ( exp + 112 ) << 23 ) | ( mant << 13 );
+    else if ( !mant )                   // zero
+        bits = sign;
+    else                                // subnormal, normalize the mantissa
+    {
+        exp = 113;
+
+        while ( !( mant & 0x400 ) )
+        {
+            mant <<= 1;
+            exp--;
+        }
+
+        bits = sign | ( exp << 23 ) | ( ( mant & 0x3ff ) << 13 );
+    }
+
+    float f;
+    memcpy( &f, &bits, sizeof( f ) );
+
+    return f;
+}
+
+/* ====== SCALAR KERNELS ====== */
+
+static void
+rgbToBgrScalar( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width, bool mirror )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint8_t* s = src + 3 * x;
+        uint8_t*       d = dst + 3 * ( mirror ? ( width - 1 - x ) : x );
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+    }
+}
+
+static void
+rgbToBgrRowScalar( const uint8_t* src, uint8_t* dst, unsigned int width, bool mirror )
+{
+    rgbToBgrScalar( src, dst, 0, width, mirror );
+}
+
+static void
+rgbaToBgraSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint8_t* s = src + 4 * x;
+        uint8_t*       d = dst + 4 * x;
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+        d[3] = s[3];
+    }
+}
+
+static void
+rgb16ToBgr16Span( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint16_t* s = ( const uint16_t* ) ( src + 6 * x );
+        uint16_t*       d = ( uint16_t* ) ( dst + 6 * x );
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+    }
+}
+
+static void
+rgba16ToBgra16Span( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint16_t* s = ( const uint16_t* ) ( src + 8 * x );
+        uint16_t*       d = ( uint16_t* ) ( dst + 8 * x );
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+        d[3] = s[3];
+    }
+}
+
+static void
+rgb32fToBgr32fSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint32_t* s = ( const uint32_t* ) ( src + 12 * x );
+        uint32_t*       d = ( uint32_t* ) ( dst + 12 * x );
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+    }
+}
+
+static void
+rgba32fToBgra32fSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint32_t* s = ( const uint32_t* ) ( src + 16 * x );
+        uint32_t*       d = ( uint32_t* ) ( dst + 16 * x );
+
+        d[0] = s[2];
+        d[1] = s[1];
+        d[2] = s[0];
+        d[3] = s[3];
+    }
+}
+
+static void
+rgb16fToBgr32fSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint16_t* s = ( const uint16_t* ) ( src + 6 * x );
+        float*          d = ( float* ) ( dst + 12 * x );
+
+        d[0] = halfToFloat( s[2] );
+        d[1] = halfToFloat( s[1] );
+        d[2] = halfToFloat( s[0] );
+    }
+}
+
+static void
+rgba16fToBgra32fSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    for ( ; x < width; x++ )
+    {
+        const uint16_t* s = ( const uint16_t* ) ( src + 8 * x );
+        float*          d = ( float* ) ( dst + 16 * x );
+
+        d[0] = halfToFloat( s[2] );
+        d[1] = halfToFloat( s[1] );
+        d[2] = halfToFloat( s[0] );
+        d[3] = halfToFloat( s[3] );
+    }
+}
+
+static void
+red16fToRed32fSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    const uint16_t* s = ( const uint16_t* ) src;
+    float*          d = ( float* ) dst;
+
+    for ( ; x < width; x++ )
+        d[x] = halfToFloat( s[x] );
+}
+
+static void
+u24ToUnitSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    float* d = ( float* ) dst;
+
+    for ( ; x < width; x++ )
+    {
+        const uint8_t* s = src + 3 * x;
+
+        d[x] = ( float ) ( s[0] | ( s[1] << 8 ) | ( s[2] << 16 ) ) * ( 1.0f / 16777215.0f );
+    }
+}
+
+static void
+u32ToUnitSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    const uint32_t* s = ( const uint32_t* ) src;
+    float*          d = ( float* ) dst;
+
+    for ( ; x < width; x++ )
+        d[x] = ( float ) ( ( double ) s[x] * ( 1.0 / 4294967295.0 ) );
+}
+
+static void
+r5g6b5ToBgrSpan( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    const uint16_t* s = ( const uint16_t* ) src;
+
+    for ( ; x < width; x++ )
+    {
+        unsigned int v = s[x];
+        unsigned int r = ( v >> 11 ) & 0x1f;
+        unsigned int g = ( v >> 5 ) & 0x3f;
+        unsigned int b = v & 0x1f;
+        uint8_t*     d = dst + 3 * x;
+
+        d[0] = ( uint8_t ) ( ( b << 3 ) | ( b >> 2 ) );
+        d[1] = ( uint8_t ) ( ( g << 2 ) | ( g >> 4 ) );
+        d[2] = ( uint8_t ) ( ( r << 3 ) | ( r >> 2 ) );
+    }
+}
+
+static void
+copy8Span( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    memcpy( dst + x, src + x, width - x );
+}
+
+static void
+copy16Span( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    memcpy( dst + 2 * x, src + 2 * x, 2 * ( size_t ) ( width - x ) );
+}
+
+static void
+copy32Span( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width )
+{
+    memcpy( dst + 4 * x, src + 4 * x, 4 * ( size_t ) ( width - x ) );
+}
+
+#ifdef PIXEL_CONVERT_X86
+
+/* ====== SSSE3 KERNELS ====== */
+
+/**
+* RGB8: five pixels per 16 byte load; the store writes one byte beyond the five
+* pixels, which always belongs to a pixel that is converted later on
+*/
+__attribute__(( target( "ssse3" ) )) static unsigned int
+rgbToBgrSsse3( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width, bool mirror )
+{
+    if ( mirror )
+    {
+        // reversing the bytes of five RGB pixels yields the five pixels in reverse order as BGR
+        const __m128i mask = _mm_setr_epi8( -128, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0 );
+
+        for ( ; x + 6 <= width; x += 5 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* ) ( src + 3 * x ) );
+            _mm_storeu_si128( ( __m128i* ) ( dst + 3 * ( width - 5 - x ) - 1 ), _mm_shuffle_epi8( v, mask ) );
+        }
+    }
+    else
+    {
+        const __m128i mask = _mm_setr_epi8( 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, 14, 13, 12, -128 );
+
+        for ( ; x + 6 <= width; x += 5 )
+        {
+            __m128i v = _mm_loadu_si128( ( const __m128i* ) ( src + 3 * x ) );
+            _mm_storeu_si128( ( __m128i* ) ( dst + 3 * x ), _mm_shuffle_epi8( v, mask ) );
+        }
+    }
+
+    return x;
+}
+
+__attribute__(( target( "ssse3" ) )) static void
+rgbToBgrRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool mirror )
+{
+    unsigned int x = rgbToBgrSsse3( src, dst, 0, width, mirror );
+
+    rgbToBgrScalar( src, dst, x, width, mirror );
+}
+
+/**
+* in-lane byte shuffle of whole 16 byte blocks; the pixel size must divide 16
+*/
+__attribute__(( target( "ssse3" ) )) static unsigned int
+shuffleBlocksSsse3( const uint8_t* src, uint8_t* dst, unsigned int x, unsigned int width, unsigned int pixelSize, __m128i mask )
+{
+    unsigned int step = 16 / pixelSize;
+
+    for ( ; x + step <= width; x += step )
+    {
+        __m128i v = _mm_loadu_si128( ( const __m128i* ) ( src + pixelSize * x ) );
+        _mm_storeu_si128( ( __m128i* ) ( dst + pixelSize * x ), _mm_shuffle_epi8( v, mask ) );
+    }
+
+    return x;
+}
+
+__attribute__(( target( "ssse3" ) )) static void
+rgbaToBgraRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m128i mask = _mm_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+
+    rgbaToBgraSpan( src, dst, shuffleBlocksSsse3( src, dst, 0, width, 4, mask ), width );
+}
+
+__attribute__(( target( "ssse3" ) )) static void
+rgba16ToBgra16RowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m128i mask = _mm_setr_epi8( 4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15 );
+
+    rgba16ToBgra16Span( src, dst, shuffleBlocksSsse3( src, dst, 0, width, 8, mask ), width );
+}
+
+/**
+* RGB16: two pixels per 16 byte load, the 4 spare bytes of the store land on the next pixel
+*/
+__attribute__(( target( "ssse3" ) )) static void
+rgb16ToBgr16RowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m128i mask = _mm_setr_epi8( 4, 5, 2, 3, 0, 1, 10, 11, 8, 9, 6, 7, -128, -128, -128, -128 );
+    unsigned int  x    = 0;
+
+    for ( ; x + 3 <= width; x += 2 )
+    {
+        __m128i v = _mm_loadu_si128( ( const __m128i* ) ( src + 6 * x ) );
+        _mm_storeu_si128( ( __m128i* ) ( dst + 6 * x ), _mm_shuffle_epi8( v, mask ) );
+    }
+
+    rgb16ToBgr16Span( src, dst, x, width );
+}
+
+/**
+* RGB32F: one pixel per 16 byte load, the spare float of the store lands on the next pixel
+*/
+__attribute__(( target( "ssse3" ) )) static void
+rgb32fToBgr32fRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    unsigned int x = 0;
+
+    for ( ; x + 2 <= width; x++ )
+    {
+        __m128 v = _mm_loadu_ps( ( const float* ) ( src + 12 * x ) );
+        _mm_storeu_ps( ( float* ) ( dst + 12 * x ), _mm_shuffle_ps( v, v, _MM_SHUFFLE( 3, 0, 1, 2 ) ) );
+    }
+
+    rgb32fToBgr32fSpan( src, dst, x, width );
+}
+
+__attribute__(( target( "ssse3" ) )) static void
+rgba32fToBgra32fRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    for ( unsigned int x = 0; x < width; x++ )
+    {
+        __m128 v = _mm_loadu_ps( ( const float* ) ( src + 16 * x ) );
+        _mm_storeu_ps( ( float* ) ( dst + 16 * x ), _mm_shuffle_ps( v, v, _MM_SHUFFLE( 3, 0, 1, 2 ) ) );
+    }
+}
+
+/**
+* 24 bit depth: four pixels per 16 byte load, widened to 32 bit and normalized
+*/
+__attribute__(( target( "ssse3" ) )) static void
+u24ToUnitRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m128i mask  = _mm_setr_epi8( 0, 1, 2, -128, 3, 4, 5, -128, 6, 7, 8, -128, 9, 10, 11, -128 );
+    const __m128  scale = _mm_set1_ps( 1.0f / 16777215.0f );
+    unsigned int  x     = 0;
+
+    for ( ; x + 6 <= width; x += 4 )
+    {
+        __m128i v = _mm_shuffle_epi8( _mm_loadu_si128( ( const __m128i* ) ( src + 3 * x ) ), mask );
+        _mm_storeu_ps( ( float* ) dst + x, _mm_mul_ps( _mm_cvtepi32_ps( v ), scale ) );
+    }
+
+    u24ToUnitSpan( src, dst, x, width );
+}
+
+/**
+* 32 bit unsigned: there is no unsigned conversion, so both halves are converted separately
+*/
+__attribute__(( target( "ssse3" ) )) static void
+u32ToUnitRowSsse3( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m128i low   = _mm_set1_epi32( 0xffff );
+    const __m128  shift = _mm_set1_ps( 65536.0f );
+    const __m128  scale = _mm_set1_ps( 1.0f / 4294967295.0f );
+    unsigned int  x     = 0;
+
+    for ( ; x + 4 <= width; x += 4 )
+    {
+        __m128i v  = _mm_loadu_si128( ( const __m128i* ) ( src + 4 * x ) );
+        __m128  hi = _mm_cvtepi32_ps( _mm_srli_epi32( v, 16 ) );
+        __m128  lo = _mm_cvtepi32_ps( _mm_and_si128( v, low ) );
+        _mm_storeu_ps( ( float* ) dst + x, _mm_mul_ps( _mm_add_ps( _mm_mul_ps( hi, shift ), lo ), scale ) );
+    }
+
+    u32ToUnitSpan( src, dst, x, width );
+}
+
+/* ====== AVX2 KERNELS ====== */
+
+/**
+* RGB8: eight pixels per 32 byte load; the 24 bytes are spread over both 128 bit lanes
+* (pshufb does not cross lanes), swizzled and packed again, the 8 spare bytes of the
+* store land on pixels which are converted later on
+*/
+__attribute__(( target( "avx2" ) )) static void
+rgbToBgrRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool mirror )
+{
+    unsigned int x = 0;
+
+    if ( mirror )
+    {
+        // lane 0 receives pixels 4..7, lane 1 pixels 0..3; both are reversed within the lane
+        const __m256i spread = _mm256_setr_epi32( 3, 4, 5, 0, 0, 1, 2, 0 );
+        const __m256i pack   = _mm256_setr_epi32( 3, 7, 0, 1, 2, 4, 5, 6 );
+        const __m256i mask   = _mm256_setr_epi8( 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, -128, -128, -128, -128,
+                                                 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, -128, -128, -128, -128 );
+
+        for ( ; x + 11 <= width; x += 8 )
+        {
+            __m256i v = _mm256_loadu_si256( ( const __m256i* ) ( src + 3 * x ) );
+            v = _mm256_permutevar8x32_epi32( v, spread );
+            v = _mm256_shuffle_epi8( v, mask );
+            v = _mm256_permutevar8x32_epi32( v, pack );
+            _mm256_storeu_si256( ( __m256i* ) ( dst + 3 * ( width - 8 - x ) - 8 ), v );
+        }
+    }
+    else
+    {
+        const __m256i spread = _mm256_setr_epi32( 0, 1, 2, 0, 3, 4, 5, 0 );
+        const __m256i pack   = _mm256_setr_epi32( 0, 1, 2, 4, 5, 6, 3, 7 );
+        const __m256i mask   = _mm256_setr_epi8( 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -128, -128, -128, -128,
+                                                 2, 1, 0, 5, 4, 3, 8, 7, 6, 11, 10, 9, -128, -128, -128, -128 );
+
+        for ( ; x + 11 <= width; x += 8 )
+        {
+            __m256i v = _mm256_loadu_si256( ( const __m256i* ) ( src + 3 * x ) );
+            v = _mm256_permutevar8x32_epi32( v, spread );
+            v = _mm256_shuffle_epi8( v, mask );
+            v = _mm256_permutevar8x32_epi32( v, pack );
+            _mm256_storeu_si256( ( __m256i* ) ( dst + 3 * x ), v );
+        }
+    }
+
+    x = rgbToBgrSsse3( src, dst, x, width, mirror );
+
+    rgbToBgrScalar( src, dst, x, width, mirror );
+}
+
+/**
+* in-lane byte shuffle of whole 32 byte blocks; the pixel size must divide 16
+*/
+__attribute__(( target( "avx2" ) )) static unsigned int
+shuffleBlocksAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, unsigned int pixelSize, __m256i mask )
+{
+    unsigned int step = 32 / pixelSize;
+    unsigned int x    = 0;
+
+    for ( ; x + step <= width; x += step )
+    {
+        __m256i v = _mm256_loadu_si256( ( const __m256i* ) ( src + pixelSize * x ) );
+        _mm256_storeu_si256( ( __m256i* ) ( dst + pixelSize * x ), _mm256_shuffle_epi8( v, mask ) );
+    }
+
+    return x;
+}
+
+__attribute__(( target( "avx2" ) )) static void
+rgbaToBgraRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m256i mask = _mm256_setr_epi8( 2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                           2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15 );
+
+    rgbaToBgraSpan( src, dst, shuffleBlocksAvx2( src, dst, width, 4, mask ), width );
+}
+
+__attribute__(( target( "avx2" ) )) static void
+rgba16ToBgra16RowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    const __m256i mask = _mm256_setr_epi8( 4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15,
+                                           4, 5, 2, 3, 0, 1, 6, 7, 12, 13, 10, 11, 8, 9, 14, 15 );
+
+    rgba16ToBgra16Span( src, dst, shuffleBlocksAvx2( src, dst, width, 8, mask ), width );
+}
+
+__attribute__(( target( "avx2" ) )) static void
+rgba32fToBgra32fRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    unsigned int x = 0;
+
+    for ( ; x + 2 <= width; x += 2 )
+    {
+        __m256 v = _mm256_loadu_ps( ( const float* ) ( src + 16 * x ) );
+        _mm256_storeu_ps( ( float* ) ( dst + 16 * x ), _mm256_permute_ps( v, _MM_SHUFFLE( 3, 0, 1, 2 ) ) );
+    }
+
+    rgba32fToBgra32fSpan( src, dst, x, width );
+}
+
+/**
+* half floats: eight values per 16 byte load, widened with F16C (available on all AVX2 CPUs)
+*/
+__attribute__(( target( "avx2,f16c" ) )) static void
+rgb16fToBgr32fRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    // two pixels per step, the 2 spare floats of the store land on the next pixel
+    const __m256i order = _mm256_setr_epi32( 2, 1, 0, 5, 4, 3, 6, 7 );
+    unsigned int  x     = 0;
+
+    for ( ; x + 3 <= width; x += 2 )
+    {
+        __m256 v = _mm256_cvtph_ps( _mm_loadu_si128( ( const __m128i* ) ( src + 6 * x ) ) );
+        _mm256_storeu_ps( ( float* ) ( dst + 12 * x ), _mm256_permutevar8x32_ps( v, order ) );
+    }
+
+    rgb16fToBgr32fSpan( src, dst, x, width );
+}
+
+__attribute__(( target( "avx2,f16c" ) )) static void
+rgba16fToBgra32fRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    unsigned int x = 0;
+
+    for ( ; x + 2 <= width; x += 2 )
+    {
+        __m256 v = _mm256_cvtph_ps( _mm_loadu_si128( ( const __m128i* ) ( src + 8 * x ) ) );
+        _mm256_storeu_ps( ( float* ) ( dst + 16 * x ), _mm256_permute_ps( v, _MM_SHUFFLE( 3, 0, 1, 2 ) ) );
+    }
+
+    rgba16fToBgra32fSpan( src, dst, x, width );
+}
+
+__attribute__(( target( "avx2,f16c" ) )) static void
+red16fToRed32fRowAvx2( const uint8_t* src, uint8_t* dst, unsigned int width, bool )
+{
+    unsigned int x = 0;
+
+    for ( ; x + 8 <= width; x += 8 )
+        _mm256_storeu_ps( ( float* ) dst + x, _mm256_cvtph_ps( _mm_loadu_si128( ( const __m128i* ) ( src + 2 * x ) ) ) );
+
+    red16fToRed32fSpan( src, dst, x, width );
+}
+
+#endif /* PIXEL_CONVERT_X86 */
+
+/* ====== CONVERSION TABLE ====== */
+
+/**
+* row routines of a conversion for each SIMD variant; 0 if there is no special variant
+*/
+typedef struct
+{
+    uint16_t      pixelFormat;
+    uint8_t       pixelSize;
+    uint8_t       channels;
+    uint8_t       channelType;
+    bool          mirrors;
+    const char*   name;
+    PixelRowFunc  scalar;
+    PixelRowFunc  ssse3;
+    PixelRowFunc  avx2;
+} PIXEL_KERNELS_t;
+
+#ifdef PIXEL_CONVERT_X86
+#define KERNEL_X86( f ) f
+#else
+#define KERNEL_X86( f ) 0
+#endif
+
+static const PIXEL_KERNELS_t sKernels[] =
+{
+    // 8 bit colour
+    { RDB_PIX_FORMAT_RGB8,       24, 3, PIXEL_CHANNEL_U8,  true,  "RGB8",      rgbToBgrRowScalar,                  KERNEL_X86( rgbToBgrRowSsse3 ),         KERNEL_X86( rgbToBgrRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGB_24,     24, 3, PIXEL_CHANNEL_U8,  true,  "RGB_24",    rgbToBgrRowScalar,                  KERNEL_X86( rgbToBgrRowSsse3 ),         KERNEL_X86( rgbToBgrRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGBA8,      32, 4, PIXEL_CHANNEL_U8,  false, "RGBA8",     scalarRow<rgbaToBgraSpan>,          KERNEL_X86( rgbaToBgraRowSsse3 ),       KERNEL_X86( rgbaToBgraRowAvx2 ) },
+    { RDB_PIX_FORMAT_R5_G6_B5,   16, 3, PIXEL_CHANNEL_U8,  false, "R5_G6_B5",  scalarRow<r5g6b5ToBgrSpan>,         0,                                      0 },
+    { RDB_PIX_FORMAT_RGB_16,     16, 3, PIXEL_CHANNEL_U8,  false, "RGB_16",    scalarRow<r5g6b5ToBgrSpan>,         0,                                      0 },
+
+    // 16 bit colour
+    { RDB_PIX_FORMAT_RGB16,      48, 3, PIXEL_CHANNEL_U16, false, "RGB16",     scalarRow<rgb16ToBgr16Span>,        KERNEL_X86( rgb16ToBgr16RowSsse3 ),     0 },
+    { RDB_PIX_FORMAT_RGBA16,     64, 4, PIXEL_CHANNEL_U16, false, "RGBA16",    scalarRow<rgba16ToBgra16Span>,      KERNEL_X86( rgba16ToBgra16RowSsse3 ),   KERNEL_X86( rgba16ToBgra16RowAvx2 ) },
+
+    // floating point colour
+    { RDB_PIX_FORMAT_RGB16F,     48, 3, PIXEL_CHANNEL_F32, false, "RGB16F",    scalarRow<rgb16fToBgr32fSpan>,      0,                                      KERNEL_X86( rgb16fToBgr32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGB_16_F,   48, 3, PIXEL_CHANNEL_F32, false, "RGB_16_F",  scalarRow<rgb16fToBgr32fSpan>,      0,                                      KERNEL_X86( rgb16fToBgr32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGBA16F,    64, 4, PIXEL_CHANNEL_F32, false, "RGBA16F",   scalarRow<rgba16fToBgra32fSpan>,    0,                                      KERNEL_X86( rgba16fToBgra32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGBA_16_F,  64, 4, PIXEL_CHANNEL_F32, false, "RGBA_16_F", scalarRow<rgba16fToBgra32fSpan>,    0,                                      KERNEL_X86( rgba16fToBgra32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGB32F,     96, 3, PIXEL_CHANNEL_F32, false, "RGB32F",    scalarRow<rgb32fToBgr32fSpan>,      KERNEL_X86( rgb32fToBgr32fRowSsse3 ),   0 },
+    { RDB_PIX_FORMAT_RGB_32_F,   96, 3, PIXEL_CHANNEL_F32, false, "RGB_32_F",  scalarRow<rgb32fToBgr32fSpan>,      KERNEL_X86( rgb32fToBgr32fRowSsse3 ),   0 },
+    { RDB_PIX_FORMAT_RGBA32F,   128, 4, PIXEL_CHANNEL_F32, false, "RGBA32F",   scalarRow<rgba32fToBgra32fSpan>,    KERNEL_X86( rgba32fToBgra32fRowSsse3 ), KERNEL_X86( rgba32fToBgra32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RGBA_32_F, 128, 4, PIXEL_CHANNEL_F32, false, "RGBA_32_F", scalarRow<rgba32fToBgra32fSpan>,    KERNEL_X86( rgba32fToBgra32fRowSsse3 ), KERNEL_X86( rgba32fToBgra32fRowAvx2 ) },
+
+    // single channel
+    { RDB_PIX_FORMAT_RED8,        8, 1, PIXEL_CHANNEL_U8,  false, "RED8",      scalarRow<copy8Span>,               0,                                      0 },
+    { RDB_PIX_FORMAT_BW_8,        8, 1, PIXEL_CHANNEL_U8,  false, "BW_8",      scalarRow<copy8Span>,               0,                                      0 },
+    { RDB_PIX_FORMAT_RED16,      16, 1, PIXEL_CHANNEL_U16, false, "RED16",     scalarRow<copy16Span>,              0,                                      0 },
+    { RDB_PIX_FORMAT_BW_16,      16, 1, PIXEL_CHANNEL_U16, false, "BW_16",     scalarRow<copy16Span>,              0,                                      0 },
+    { RDB_PIX_FORMAT_RED16F,     16, 1, PIXEL_CHANNEL_F32, false, "RED16F",    scalarRow<red16fToRed32fSpan>,      0,                                      KERNEL_X86( red16fToRed32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_LUM_16_F,   16, 1, PIXEL_CHANNEL_F32, false, "LUM_16_F",  scalarRow<red16fToRed32fSpan>,      0,                                      KERNEL_X86( red16fToRed32fRowAvx2 ) },
+    { RDB_PIX_FORMAT_RED32F,     32, 1, PIXEL_CHANNEL_F32, false, "RED32F",    scalarRow<copy32Span>,              0,                                      0 },
+    { RDB_PIX_FORMAT_LUM_32_F,   32, 1, PIXEL_CHANNEL_F32, false, "LUM_32_F",  scalarRow<copy32Span>,              0,                                      0 },
+
+    // depth; 24 and 32 bit values are normalized to [0, 1]
+    { RDB_PIX_FORMAT_DEPTH8,      8, 1, PIXEL_CHANNEL_U8,  false, "DEPTH8",    scalarRow<copy8Span>,               0,                                      0 },
+    { RDB_PIX_FORMAT_DEPTH_8,     8, 1, PIXEL_CHANNEL_U8,  false, "DEPTH_8",   scalarRow<copy8Span>,               0,                                      0 },
+    { RDB_PIX_FORMAT_DEPTH16,    16, 1, PIXEL_CHANNEL_U16, false, "DEPTH16",   scalarRow<copy16Span>,              0,                                      0 },
+    { RDB_PIX_FORMAT_DEPTH_16,   16, 1, PIXEL_CHANNEL_U16, false, "DEPTH_16",  scalarRow<copy16Span>,              0,                                      0 },
+    { RDB_PIX_FORMAT_DEPTH24,    24, 1, PIXEL_CHANNEL_F32, false, "DEPTH24",   scalarRow<u24ToUnitSpan>,           KERNEL_X86( u24ToUnitRowSsse3 ),        0 },
+    { RDB_PIX_FORMAT_DEPTH_24,   24, 1, PIXEL_CHANNEL_F32, false, "DEPTH_24",  scalarRow<u24ToUnitSpan>,           KERNEL_X86( u24ToUnitRowSsse3 ),        0 },
+    { RDB_PIX_FORMAT_DEPTH32,    32, 1, PIXEL_CHANNEL_F32, false, "DEPTH32",   scalarRow<u32ToUnitSpan>,           KERNEL_X86( u32ToUnitRowSsse3 ),        0 },
+    { RDB_PIX_FORMAT_DEPTH_32,   32, 1, PIXEL_CHANNEL_F32, false, "DEPTH_32",  scalarRow<u32ToUnitSpan>,           KERNEL_X86( u32ToUnitRowSsse3 ),        0 }
+};
+
+static const unsigned int sNoKernels = sizeof( sKernels ) / sizeof( sKernels[0] );
+
+/**
+* the conversion table with the row routines picked for the CPU, indexed by pixel format
+*/
+struct ConversionTable
+{
+    PIXEL_CONVERSION_t  entries[ sizeof( sKernels ) / sizeof( sKernels[0] ) ];
+    int                 byFormat[ 256 ];        // index into entries, -1 if unsupported
+    const char*         isa;
+
+    ConversionTable() : isa( "scalar" )
+    {
+        bool haveSsse3 = false;
+        bool haveAvx2  = false;
+
+#ifdef PIXEL_CONVERT_X86
+        __builtin_cpu_init();
+
+        haveSsse3 = __builtin_cpu_supports( "ssse3" );
+        haveAvx2  = __builtin_cpu_supports( "avx2" );
+
+        if ( haveAvx2 )
+            isa = "avx2";
+        else if ( haveSsse3 )
+            isa = "ssse3";
+#endif
+
+        for ( unsigned int i = 0; i < 256; i++ )
+            byFormat[ i ] = -1;
+
+        for ( unsigned int i = 0; i < sNoKernels; i++ )
+        {
+            const PIXEL_KERNELS_t& k = sKernels[ i ];
+            PIXEL_CONVERSION_t&    e = entries[ i ];
+
+            e.pixelFormat = k.pixelFormat;
+            e.pixelSize   = k.pixelSize;
+            e.channels    = k.channels;
+            e.channelType = k.channelType;
+            e.mirrors     = k.mirrors;
+            e.name        = k.name;
+            e.convertRow  = k.scalar;
+
+            if ( haveAvx2 && k.avx2 )
+                e.convertRow = k.avx2;
+            else if ( haveSsse3 && k.ssse3 )
+                e.convertRow = k.ssse3;
+
+            if ( k.pixelFormat < 256 )
+                byFormat[ k.pixelFormat ] = i;
+        }
+    }
+};
+
+static const ConversionTable&
+conversionTable()
+{
+    static ConversionTable table;
+
+    return table;
+}
+
+/**
+* reverse the order of the pixels of a row which is still in the cache
+*/
+static void
+mirrorRow( uint8_t* row, unsigned int width, size_t pixelSize )
+{
+    uint8_t tmp[ 16 ];
+
+    uint8_t* left  = row;
+    uint8_t* right = row + ( width - 1 ) * pixelSize;
+
+    for ( ; left < right; left += pixelSize, right -= pixelSize )
+    {
+        memcpy( tmp, left, pixelSize );
+        memcpy( left, right, pixelSize );
+        memcpy( right, tmp, pixelSize );
+    }
+}
+
+/**
+* check whether the rows of a conversion are plain copies of the source rows
+*/
+static bool
+isPlainCopy( const PIXEL_CONVERSION_t* conv )
+{
+    return ( conv->convertRow == scalarRow<copy8Span> ) || ( conv->convertRow == scalarRow<copy16Span> ) ||
+           ( conv->convertRow == scalarRow<copy32Span> );
+}
+
+const PIXEL_CONVERSION_t*
+findPixelConversion( uint16_t pixelFormat, uint8_t pixelSize )
+{
+    const ConversionTable& table = conversionTable();
+
+    if ( pixelFormat >= 256 )
+        return 0;
+
+    int index = table.byFormat[ pixelFormat ];
+
+    if ( ( index < 0 ) || ( table.entries[ index ].pixelSize != pixelSize ) )
+        return 0;
+
+    return &table.entries[ index ];
+}
+
+const PIXEL_CONVERSION_t*
+findPixelConversion( const char* name )
+{
+    const ConversionTable& table = conversionTable();
+
+    for ( unsigned int i = 0; i < sNoKernels; i++ )
+    {
+        if ( !strcasecmp( table.entries[ i ].name, name ) )
+            return &table.entries[ i ];
+    }
+
+    return 0;
+}
+
+size_t
+convertedPixelSize( const PIXEL_CONVERSION_t* conv )
+{
+    static const size_t channelSize[] = { 1, 2, 4 };
+
+    return conv->channels * channelSize[ conv->channelType ];
+}
+
+void
+convertImage( const PIXEL_CONVERSION_t* conv, const void* src, void* dst, unsigned int width, unsigned int height, int orientation )
+{
+    size_t srcRowSize = ( size_t ) width * ( conv->pixelSize / 8 );
+    size_t dstPixSize = convertedPixelSize( conv );
+    size_t dstRowSize = ( size_t ) width * dstPixSize;
+    bool   bottomUp   = ( orientation == IMAGE_ORIENT_FLIP_VERTICAL ) || ( orientation == IMAGE_ORIENT_ROTATE_180 );
+    bool   mirror     = ( orientation == IMAGE_ORIENT_ROTATE_180 ) || ( orientation == IMAGE_ORIENT_FLIP_HORIZONTAL );
+
+    const uint8_t* srcRow = ( const uint8_t* ) src;
+    uint8_t*       dstRow = ( uint8_t* ) dst;
+
+    // large images which are plain copies of the source are written with non-temporal stores, so that
+    // they do not push the encoders out of the cache; streaming the rows of the other conversions through
+    // a row buffer costs more than it saves
+    if ( isPlainCopy( conv ) && !mirror && streamCopyUsed( dstRowSize * height ) )
+    {
+        for ( unsigned int y = 0; y < height; y++ )
+            streamCopyUnfenced( dstRow + dstRowSize * y, srcRow + srcRowSize * ( bottomUp ? ( height - 1 - y ) : y ), dstRowSize );
+
+        streamCopyFence();
+        return;
+    }
+
+    // the destination is written sequentially, the vertical flip is done by reading the source rows bottom-up
+    for ( unsigned int y = 0; y < height; y++ )
+    {
+        const uint8_t* s = srcRow + srcRowSize * ( bottomUp ? ( height - 1 - y ) : y );
+        uint8_t*       d = dstRow + dstRowSize * y;
+
+        conv->convertRow( s, d, width, mirror );
+
+        // conversions without a mirroring kernel reverse the row while it is still in the cache
+        if ( mirror && !conv->mirrors )
+            mirrorRow( d, width, dstPixSize );
+    }
+}
+
+const char*
+pixelConvertIsa()
+{
+    return conversionTable().isa;
+}
+
+} // namespace Framework
@@ -0,0 +1,268 @@
+/* ===================================================
+ *  file:       PointCloud.cc
+ * ---------------------------------------------------
+ *  purpose:	back-projection of RDB depth images into
+ *              point clouds and their output
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include <errno.h>
+#include "PointCloud.hh"
+#include "AsyncLog.hh"
+
+#if defined( __SSE2__ )
+#include <emmintrin.h>
+#endif
+
+namespace Framework
+{
+
+DepthProjector::DepthProjector() : mPixelFormat( 0 ),
+                                   mPixelSize( 0 ),
+                                   mWidth( 0 ),
+                                   mHeight( 0 ),
+                                   mDecode( 0 ),
+                                   mZbufA( 0.0f ),
+                                   mZbufB( 0.0f ),
+                                   mZbufC( 0.0f )
+{
+    memset( &mCamera, 0, sizeof( mCamera ) );
+}
+
+DepthProjector::~DepthProjector()
+{
+}
+
+bool
+DepthProjector::isDepthFormat( uint16_t pixelFormat, uint8_t pixelSize )
+{
+    switch ( pixelFormat )
+    {
+        case RDB_PIX_FORMAT_DEPTH16:
+        case RDB_PIX_FORMAT_DEPTH_16:
+            return pixelSize == 16;
+
+        case RDB_PIX_FORMAT_DEPTH24:
+        case RDB_PIX_FORMAT_DEPTH_24:
+            return pixelSize == 24;
+
+        case RDB_PIX_FORMAT_DEPTH32:
+        case RDB_PIX_FORMAT_DEPTH_32:
+        case RDB_PIX_FORMAT_RED32F:
+            return pixelSize == 32;
+
+        default:
+            return false;
+    }
+}
+
+bool
+DepthProjector::setup( const RDB_CAMERA_t & camera, const RDB_IMAGE_t & image )
+{
+    if ( !isDepthFormat( image.pixelFormat, image.pixelSize ) || !image.width || !image.height )
+        return false;
+
+    if ( ( camera.focalX <= 0.0f ) || ( camera.focalY <= 0.0f ) )
+        return false;
+
+    // nothing to do while camera and image stay the same
+    if ( ( image.pixelFormat == mPixelFormat ) && ( image.pixelSize == mPixelSize ) &&
+         ( image.width == mWidth ) && ( image.height == mHeight ) && !memcmp( &camera, &mCamera, sizeof( camera ) ) )
+        return true;
+
+    mCamera      = camera;
+    mPixelFormat = image.pixelFormat;
+    mPixelSize   = image.pixelSize;
+    mWidth       = image.width;
+    mHeight      = image.height;
+
+    // DEPTH16 is kept as integer by the conversion table, all other formats are decoded into floats by it
+    mDecode = ( mPixelSize == 16 ) ? 0 : findPixelConversion( mPixelFormat, mPixelSize );
+
+    // linearization of the z-buffer: d = 0 at the near and d = 1 at the far clipping plane
+    mZbufA = camera.clipNear * camera.clipFar;
+    mZbufB = camera.clipFar;
+    mZbufC = camera.clipFar - camera.clipNear;
+
+    // the intrinsics refer to the viewport, which may differ in size from the image
+    float scaleX = camera.width  ? ( float ) mWidth  / camera.width  : 1.0f;
+    float scaleY = camera.height ? ( float ) mHeight / camera.height : 1.0f;
+
+    float fx = camera.focalX * scaleX;
+    float fy = camera.focalY * scaleY;
+    float cx = camera.principalX * scaleX;
+    float cy = camera.principalY * scaleY;
+
+    mColFactor.resize( mWidth );
+    mRowFactor.resize( mHeight );
+    mDepthRow.resize( mWidth );
+
+    for ( unsigned int u = 0; u < mWidth; u++ )
+        mColFactor[ u ] = ( u - cx ) / fx;
+
+    for ( unsigned int v = 0; v < mHeight; v++ )
+        mRowFactor[ v ] = ( v - cy ) / fy;
+
+    return true;
+}
+
+size_t
+DepthProjector::getOutputSize() const
+{
+    // the SIMD loop writes 4 bytes beyond the last point
+    return ( size_t ) mWidth * mHeight * 3 * sizeof( float ) + 16;
+}
+
+void
+DepthProjector::project( const void* src, float* dst, bool soa )
+{
+    size_t       noPoints   = ( size_t ) mWidth * mHeight;
+    size_t       srcRowSize = ( size_t ) mWidth * ( mPixelSize / 8 );
+    bool         metric     = ( mPixelFormat == RDB_PIX_FORMAT_RED32F );
+    float*       depth      = &mDepthRow[ 0 ];
+    const float* colFactor  = &mColFactor[ 0 ];
+
+    for ( unsigned int v = 0; v < mHeight; v++ )
+    {
+        const uint8_t* srcRow = ( const uint8_t* ) src + srcRowSize * v;
+
+        if ( mDecode )
+            mDecode->convertRow( srcRow, ( uint8_t* ) depth, mWidth, false );
+        else
+        {
+            const uint16_t* s = ( const uint16_t* ) srcRow;
+
+            for ( unsigned int u = 0; u < mWidth; u++ )
+                depth[ u ] = s[ u ] * ( 1.0f / 65535.0f );
+        }
+
+        float        rowFactor = mRowFactor[ v ];
+        size_t       first     = ( size_t ) mWidth * v;
+        unsigned int u         = 0;
+
+#if defined( __SSE2__ )
+        const __m128 zbufA = _mm_set1_ps( mZbufA );
+        const __m128 zbufB = _mm_set1_ps( mZbufB );
+        const __m128 zbufC = _mm_set1_ps( mZbufC );
+        const __m128 one   = _mm_set1_ps( 1.0f );
+        const __m128 zero  = _mm_setzero_ps();
+        const __m128 nan   = _mm_set1_ps( NAN );
+        const __m128 rowF  = _mm_set1_ps( rowFactor );
+
+        for ( ; u + 4 <= mWidth; u += 4 )
+        {
+            __m128 d = _mm_loadu_ps( depth + u );
+            __m128 z;
+            __m128 valid;
+
+            if ( metric )
+            {
+                z     = d;
+                valid = _mm_cmpgt_ps( d, zero );
+            }
+            else
+            {
+                z     = _mm_div_ps( zbufA, _mm_sub_ps( zbufB, _mm_mul_ps( d, zbufC ) ) );
+                valid = _mm_cmplt_ps( d, one );
+            }
+
+            // no depth (sky or invalid value): NaN point
+            z = _mm_or_ps( _mm_and_ps( valid, z ), _mm_andnot_ps( valid, nan ) );
+
+            __m128 x = _mm_mul_ps( _mm_loadu_ps( colFactor + u ), z );
+            __m128 y = _mm_mul_ps( rowF, z );
+
+            if ( soa )
+            {
+                _mm_storeu_ps( dst + first + u,                x );
+                _mm_storeu_ps( dst + noPoints + first + u,     y );
+                _mm_storeu_ps( dst + 2 * noPoints + first + u, z );
+            }
+            else
+            {
+                // four x y z w vectors, each store overlaps the next point by one float
+                __m128 w = zero;
+                _MM_TRANSPOSE4_PS( x, y, z, w );
+
+                float* p = dst + 3 * ( first + u );
+
+                _mm_storeu_ps( p,     x );
+                _mm_storeu_ps( p + 3, y );
+                _mm_storeu_ps( p + 6, z );
+                _mm_storeu_ps( p + 9, w );
+            }
+        }
+#endif
+
+        for ( ; u < mWidth; u++ )
+        {
+            float d     = depth[ u ];
+            bool  valid = metric ? ( d > 0.0f ) : ( d < 1.0f );
+            float z     = valid ? ( metric ? d : mZbufA / ( mZbufB - d * mZbufC ) ) : NAN;
+            float x     = colFactor[ u ] * z;
+            float y     = rowFactor * z;
+
+            if ( soa )
+            {
+                dst[ first + u ]                = x;
+                dst[ noPoints + first + u ]     = y;
+                dst[ 2 * noPoints + first + u ] = z;
+            }
+            else
+            {
+                float* p = dst + 3 * ( first + u );
+
+                p[0] = x;
+                p[1] = y;
+                p[2] = z;
+            }
+        }
+    }
+}
+
+bool
+writePointCloud( const char* fileName, const float* points, unsigned int width, unsigned int height, bool soa )
+{
+    FILE* fp = fopen( fileName, "wb" );
+
+    if ( !fp )
+    {
+        FWLOG_RATE( LOG_LEVEL_ERROR, 1000, "writePointCloud: fopen(): %s\n", strerror( errno ) );
+        return false;
+    }
+
+    size_t noPoints = ( size_t ) width * height;
+
+    if ( !soa )
+    {
+        fprintf( fp, "# .PCD v.7 - Point Cloud Data file format\n" );
+        fprintf( fp, "VERSION .7\n" );
+        fprintf( fp, "FIELDS x y z\n" );
+        fprintf( fp, "SIZE 4 4 4\n" );
+        fprintf( fp, "TYPE F F F\n" );
+        fprintf( fp, "COUNT 1 1 1\n" );
+        fprintf( fp, "WIDTH %u\n", width );
+        fprintf( fp, "HEIGHT %u\n", height );
+        fprintf( fp, "VIEWPOINT 0 0 0 1 0 0 0\n" );
+        fprintf( fp, "POINTS %lu\n", ( unsigned long ) noPoints );
+        fprintf( fp, "DATA binary\n" );
+    }
+
+    bool ok = fwrite( points, 3 * sizeof( float ), noPoints, fp ) == noPoints;
+
+    if ( fclose( fp ) || !ok )
+    {
+        FWLOG_RATE( LOG_LEVEL_ERROR, 1000, "writePointCloud: failed to write %s\n", fileName );
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Framework
@@ -11,7 +11,13 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <malloc.h>
 #include "RDBHandler.hh"
+#include "StreamCopy.hh"
+#include "ShmBuffer.hh"
+
+/* ====== DEFINITIONS ====== */
+#define RDB_MSG_MIN_CAPACITY    4096    // smallest allocation for a message composed by addPackage() @unit byte
 
 namespace Framework 
 {
@@ -857,6 +863,81 @@ void*
 RDBHandler::addPackage( RDB_MSG_t* & msg,   const double & simTime, const unsigned int & simFrame, 
                         unsigned int pkgId, unsigned int noElements, bool extended, size_t trailingData, 
                         bool isCustom )
+{
+    // the allocation may be larger than the message, the remainder is used before growing it again
+    size_t   capacity  = msg ? malloc_usable_size( msg ) : 0;
+    bool     owned     = true;
+    uint32_t lastEntry = 0;     // unknown, the message is searched for it
+    
+    return appendPackage( msg, capacity, &owned, !msg, lastEntry, simTime, simFrame, pkgId, noElements, extended, trailingData, isCustom, true );
+}
+
+bool
+RDBHandler::reserveMsg( RDB_MSG_t* & buffer, size_t & capacity, bool* owned, size_t usedSize, size_t size )
+{
+    if ( size <= capacity )
+        return true;
+    
+    // a buffer of fixed size, e.g. in shared memory, cannot grow
+    if ( !owned )
+        return false;
+    
+    // grow geometrically, so that composing a message of n packages moves it only log(n) times
+    size_t newCapacity = capacity * 2;
+    
+    if ( newCapacity < size )
+        newCapacity = size;
+    
+    if ( newCapacity < RDB_MSG_MIN_CAPACITY )
+        newCapacity = RDB_MSG_MIN_CAPACITY;
+    
+    RDB_MSG_t* pNewBuffer = 0;
+    
+    if ( *owned )
+        pNewBuffer = ( RDB_MSG_t* ) realloc( buffer, newCapacity );
+    else
+    {
+        // a buffer provided by the caller is left to the caller, the message moves to the heap
+        pNewBuffer = ( RDB_MSG_t* ) malloc( newCapacity );
+        
+        if ( pNewBuffer && usedSize )
+            memcpy( pNewBuffer, buffer, usedSize );
+    }
+    
+    if ( !pNewBuffer )
+        return false;
+    
+    buffer   = pNewBuffer;
+    capacity = newCapacity;
+    *owned   = true;
+    
+    return true;
+}
+
+uint32_t
+RDBHandler::findLastEntry( RDB_MSG_t* msg )
+{
+    char*                dataPtr        = ( ( char* ) msg ) + msg->hdr.headerSize;
+    RDB_MSG_ENTRY_HDR_t* entryHdr       = ( RDB_MSG_ENTRY_HDR_t* ) ( dataPtr );
+    uint32_t             entrySize      = entryHdr->headerSize + entryHdr->dataSize;
+    uint32_t             remainingBytes = msg->hdr.dataSize - entrySize;
+    
+    while ( remainingBytes )
+    {
+        dataPtr        += entrySize;
+        entryHdr        = ( RDB_MSG_ENTRY_HDR_t* ) ( dataPtr );
+        entrySize       = entryHdr->headerSize + entryHdr->dataSize;
+        remainingBytes -= entrySize;
+    }
+    
+    return dataPtr - ( char* ) msg;
+}
+
+void*
+RDBHandler::appendPackage( RDB_MSG_t* & buffer, size_t & capacity, bool* owned, bool newMsg, uint32_t & lastEntry,
+                           const double & simTime, const unsigned int & simFrame, 
+                           unsigned int pkgId, unsigned int noElements, bool extended, size_t trailingData, 
+                           bool isCustom, bool clearTrailingData )
 {
     if ( !noElements )
         return 0;
@@ -865,51 +946,40 @@ RDBHandler::addPackage( RDB_MSG_t* & msg,   const double & simTime, const unsign
     bool newEntry   = true;
     
     // get current size
-    uint32_t dataSize      = msg ? msg->hdr.dataSize : 0;
+    uint32_t dataSize      = newMsg ? 0 : buffer->hdr.dataSize;
     uint32_t totalSize     = dataSize + sizeof( RDB_MSG_HDR_t );
     uint32_t lastEntrySize = 0;  // current size of element if it already exists
 
-    bool newMsg = ( !msg );
-    
     uint32_t elemSize      = ( isCustom ? 0 : pkgId2size( pkgId, extended ) ) + trailingData;
     uint32_t addOnDataSize = noElements * elemSize;
     uint32_t addOnSize     = addOnDataSize;
     
     // is the package type and size the same as the last one? If so, extend the previous package instead
     // of including another entry headerSize
-    if ( autoExtend && !newMsg )
+    if ( autoExtend && !newMsg && dataSize )
     {
-        char*                dataPtr   = ( ( char* ) msg ) + msg->hdr.headerSize;
-        RDB_MSG_ENTRY_HDR_t* lastEntry = ( RDB_MSG_ENTRY_HDR_t* ) ( dataPtr );
-        lastEntrySize                  = lastEntry->headerSize + lastEntry->dataSize;
-        uint32_t remainingBytes        = msg->hdr.dataSize - lastEntrySize;
+        // without a cursor, the last entry has to be searched from the start of the message
+        if ( !lastEntry )
+            lastEntry = findLastEntry( buffer );
         
-        while ( remainingBytes )
-        {
-            dataPtr        += lastEntrySize;
-            lastEntry       = ( RDB_MSG_ENTRY_HDR_t* ) ( dataPtr );
-            lastEntrySize   = lastEntry->headerSize + lastEntry->dataSize;
-            remainingBytes -= lastEntrySize;
-        }
+        RDB_MSG_ENTRY_HDR_t* lastEntryHdr = ( RDB_MSG_ENTRY_HDR_t* ) ( ( ( char* ) buffer ) + lastEntry );
+        lastEntrySize                     = lastEntryHdr->headerSize + lastEntryHdr->dataSize;
         
-        newEntry = ( lastEntry->pkgId != pkgId ) || ( lastEntry->elementSize != elemSize );
+        newEntry = ( lastEntryHdr->pkgId != pkgId ) || ( lastEntryHdr->elementSize != elemSize );
     }
     
     // a new header is required in-between
     if ( newEntry )
         addOnSize += sizeof( RDB_MSG_ENTRY_HDR_t );
     
-    RDB_MSG_t* pNewMsg = ( RDB_MSG_t* ) ( realloc( msg, totalSize + addOnSize ) );
-        
-    if ( !pNewMsg )
+    if ( !reserveMsg( buffer, capacity, owned, newMsg ? 0 : totalSize, totalSize + addOnSize ) )
     {
         fprintf( stderr, "RDBHandler::RDBaddPackage: out of memory." );
         return 0;
     }
     
-    //fprintf( stderr, "RDBHandler::RDBaddPackage: msg = %p, pNewMsg = %p\n", msg, pNewMsg );
-    // now, message can be found at the new location
-    msg = pNewMsg;
+    // from here on, the message is to be found at the (possibly new) location of the buffer
+    RDB_MSG_t* msg = buffer;
     
     // set header info (it might be new)
     msg->hdr.dataSize = dataSize + addOnSize;
@@ -931,6 +1001,8 @@ RDBHandler::addPackage( RDB_MSG_t* & msg,   const double & simTime, const unsign
         dataPtr -= lastEntrySize;
         
     RDB_MSG_ENTRY_HDR_t* pEntry = ( RDB_MSG_ENTRY_HDR_t* ) ( dataPtr );
+    
+    lastEntry = dataPtr - ( char* ) msg;
         
     // set entry parameters
     pEntry->headerSize  = sizeof( RDB_MSG_ENTRY_HDR_t );
@@ -942,8 +1014,14 @@ RDBHandler::addPackage( RDB_MSG_t* & msg,   const double & simTime, const unsign
     // initialize the trailing data
     dataPtr += newEntry ? pEntry->headerSize : lastEntrySize;
     
-    if ( addOnDataSize )
+    if ( addOnDataSize && ( clearTrailingData || !trailingData || isCustom ) )
         memset( dataPtr, 0, addOnDataSize );
+    else if ( addOnDataSize )
+    {
+        // the trailing data is left to the caller, who is going to write all of it anyway
+        for ( unsigned int i = 0; i < noElements; i++ )
+            memset( dataPtr + i * elemSize, 0, elemSize - trailingData );
+    }
     
     // compute new pointer for insertion of data
     return dataPtr;
@@ -959,8 +1037,12 @@ RDBHandler::addCustomPackage( RDB_MSG_t* & msg,   const double & simTime, const
 void*
 RDBHandler::getFirstEntry( RDB_MSG_t* msg, unsigned int pkgId, unsigned int & noElements, bool extended )
 {
-    RDB_MSG_ENTRY_HDR_t* entryHdr = getEntryHdr( msg, pkgId, extended );
-    
+    return getEntryData( getEntryHdr( msg, pkgId, extended ), pkgId, noElements );
+}
+
+void*
+RDBHandler::getEntryData( RDB_MSG_ENTRY_HDR_t* entryHdr, unsigned int pkgId, unsigned int & noElements )
+{
     if ( !entryHdr )
         return 0;
     
@@ -2334,7 +2416,17 @@ RDBHandler::printMatrix( int *pData, unsigned int width, unsigned int height, bo
 }
         
 RDBHandler::RDBHandler() : mMsg( 0 ),
-                           mShmHdr( 0 )                          
+                           mMsgBuffer( 0 ),
+                           mMsgCapacity( 0 ),
+                           mMsgOwned( true ),
+                           mLastEntry( 0 ),
+                           mEntryIndexValid( true ),
+                           mShmHdr( 0 ),
+                           mShmMsg( 0 ),
+                           mShmMsgIndex( 0 ),
+                           mShmMsgCapacity( 0 ),
+                           mShmLastEntry( 0 ),
+                           mShmPrevUsedSize( 0 )
 {
      //std::cerr << "RDBHandler::RDBHandler: CTOR called, this=" << this << std::endl;
 }
@@ -2342,17 +2434,72 @@ RDBHandler::RDBHandler() : mMsg( 0 ),
 RDBHandler::~RDBHandler()
 {
      //std::cerr << "RDBHandler::~RDBHandler: DTOR called, this=" << this << std::endl;
-     if ( mMsg )
-         free( mMsg );
+     if ( mMsgBuffer && mMsgOwned )
+         free( mMsgBuffer );
 }
 
 void
 RDBHandler::initMsg()
 {
-    if ( mMsg )
-        free( mMsg );
-    
+    // the buffer is kept for the next message, so composing a message per frame does not allocate
     mMsg = 0;
+    
+    clearEntryIndex();
+}
+
+void
+RDBHandler::initMsg( void* buffer, size_t size )
+{
+    if ( mMsgBuffer && mMsgOwned )
+        free( mMsgBuffer );
+    
+    mMsg         = 0;
+    mMsgBuffer   = ( RDB_MSG_t* ) buffer;
+    mMsgCapacity = buffer ? size : 0;
+    mMsgOwned    = !buffer;
+    
+    clearEntryIndex();
+}
+
+bool
+RDBHandler::setMsg( const RDB_MSG_t* msg )
+{
+    if ( msg == mMsgBuffer )
+    {
+        mMsg             = mMsgBuffer;
+        mEntryIndexValid = !mMsg;
+        return true;
+    }
+    
+    initMsg();
+    
+    if ( !msg )
+        return true;
+    
+    size_t size = msg->hdr.headerSize + msg->hdr.dataSize;
+    
+    if ( !reserveMsg( size ) )
+        return false;
+    
+    memcpy( mMsgBuffer, msg, size );
+    
+    // the entries are indexed once they are asked for
+    mMsg             = mMsgBuffer;
+    mEntryIndexValid = false;
+    
+    return true;
+}
+
+bool
+RDBHandler::reserveMsg( size_t size )
+{
+    return reserveMsg( mMsgBuffer, mMsgCapacity, &mMsgOwned, getMsgTotalSize(), size );
+}
+
+size_t
+RDBHandler::getMsgCapacity()
+{
+    return mMsgCapacity;
 }
 
 void*
@@ -2360,16 +2507,28 @@ RDBHandler::addPackage( const double & simTime, const unsigned int & simFrame,
                         unsigned int pkgId,     unsigned int noElements,       
                         bool extended, size_t trailingData, bool isCustom )
 {
+    if ( !mEntryIndexValid )
+        rebuildEntryIndex();
+    
     // extend the internal message if no other is given
-    return addPackage( mMsg, simTime, simFrame, pkgId, noElements, extended, trailingData, isCustom );
+    void* data = appendPackage( mMsgBuffer, mMsgCapacity, &mMsgOwned, !mMsg, mLastEntry, simTime, simFrame, 
+                                pkgId, noElements, extended, trailingData, isCustom, true );
+    
+    if ( !data )
+        return 0;
+    
+    mMsg = mMsgBuffer;
+    
+    indexEntry( mLastEntry );
+    
+    return data;
 }
 
 void*
 RDBHandler::addCustomPackage( const double & simTime, const unsigned int & simFrame, 
                               unsigned int pkgId, unsigned int noElements, size_t elementSize )
 {
-    // extend the internal message if no other is given
-    return addCustomPackage( mMsg, simTime, simFrame, pkgId, noElements, elementSize );
+    return addPackage( simTime, simFrame, pkgId, noElements, false, elementSize, true );
 }
 
 RDB_MSG_t*
@@ -2399,13 +2558,82 @@ RDBHandler::getMsgTotalSize()
 void*
 RDBHandler::getFirstEntry( unsigned int pkgId, unsigned int & noElements, bool extended )
 {
-    return getFirstEntry( mMsg, pkgId, noElements, extended );
+    return getEntryData( getEntryHdr( pkgId, extended ), pkgId, noElements );
 }
 
 RDB_MSG_ENTRY_HDR_t*
 RDBHandler::getEntryHdr( unsigned int pkgId, bool extended )
 {
-    return getEntryHdr( mMsg, pkgId, extended );
+    if ( !mMsg )
+        return 0;
+    
+    if ( !mEntryIndexValid )
+        rebuildEntryIndex();
+    
+    size_t key = pkgId * 2 + ( extended ? 1 : 0 );
+    
+    if ( key >= mEntryIndex.size() || !mEntryIndex[ key ] )
+        return 0;
+    
+    return ( RDB_MSG_ENTRY_HDR_t* ) ( ( ( char* ) mMsg ) + mEntryIndex[ key ] );
+}
+
+void
+RDBHandler::indexEntry( uint32_t offset )
+{
+    RDB_MSG_ENTRY_HDR_t* entryHdr = ( RDB_MSG_ENTRY_HDR_t* ) ( ( ( char* ) mMsg ) + offset );
+    size_t               key      = entryHdr->pkgId * 2 + ( ( entryHdr->flags & RDB_PKG_FLAG_EXTENDED ) ? 1 : 0 );
+    
+    if ( key >= mEntryIndex.size() )
+        mEntryIndex.resize( key + 1, 0 );
+    
+    // only the first entry of a type is looked up, later ones of the same type are not of interest
+    if ( mEntryIndex[ key ] )
+        return;
+    
+    mEntryIndex[ key ] = offset;
+    mEntryKeys.push_back( key );
+}
+
+void
+RDBHandler::clearEntryIndex()
+{
+    // only the keys which have been set are reset, so that clearing costs as much as the message had entries
+    for ( size_t i = 0; i < mEntryKeys.size(); i++ )
+        mEntryIndex[ mEntryKeys[ i ] ] = 0;
+    
+    mEntryKeys.clear();
+    
+    mLastEntry       = 0;
+    mEntryIndexValid = true;
+}
+
+void
+RDBHandler::rebuildEntryIndex()
+{
+    clearEntryIndex();
+    
+    if ( !mMsg )
+        return;
+    
+    uint32_t offset         = mMsg->hdr.headerSize;
+    size_t   remainingBytes = mMsg->hdr.dataSize;
+    
+    while ( remainingBytes >= sizeof( RDB_MSG_ENTRY_HDR_t ) )
+    {
+        RDB_MSG_ENTRY_HDR_t* entryHdr  = ( RDB_MSG_ENTRY_HDR_t* ) ( ( ( char* ) mMsg ) + offset );
+        size_t               entrySize = entryHdr->headerSize + entryHdr->dataSize;
+        
+        // a broken message is indexed as far as it can be trusted
+        if ( !entryHdr->headerSize || ( entrySize > remainingBytes ) )
+            break;
+        
+        indexEntry( offset );
+        
+        mLastEntry      = offset;
+        offset         += entrySize;
+        remainingBytes -= entrySize;
+    }
 }
 
 bool
@@ -2559,7 +2787,7 @@ RDBHandler::shmBufferSetFlags( unsigned int index, unsigned int flags )
     if ( !info )
         return;
     
-    info->flags = flags;
+    __atomic_store_n( &info->flags, flags, __ATOMIC_RELEASE );
 }
 
 void
@@ -2570,7 +2798,7 @@ RDBHandler::shmBufferAddFlags( unsigned int index, unsigned int flags )
     if ( !info )
         return;
     
-    info->flags |= flags;
+    shmBufferChangeFlags( info, 0, 0, flags, 0 );
 }
 
 void
@@ -2581,7 +2809,7 @@ RDBHandler::shmBufferReleaseFlags( unsigned int index, unsigned int flags )
     if ( !info )
         return;
     
-    info->flags &= ~flags;
+    shmBufferChangeFlags( info, 0, 0, 0, flags );
 }
 
 unsigned int
@@ -2592,7 +2820,7 @@ RDBHandler::shmBufferGetFlags( unsigned int index )
     if ( !info )
         return 0;
     
-    return info->flags;
+    return Framework::shmBufferGetFlags( info );
 }
 
 bool
@@ -2603,7 +2831,7 @@ RDBHandler::shmBufferHasFlags( unsigned int index, unsigned int mask )
     if ( !info )
         return false;
     
-    return ( info->flags & mask ) == mask;
+    return ( Framework::shmBufferGetFlags( info ) & mask ) == mask;
 }
 
 bool
@@ -2622,11 +2850,17 @@ RDBHandler::mapMsgToShm( unsigned int index, bool relocateBuffers )
         // buffer size has changed, so compute the header information again
         shmHdrUpdate();
     }
-    printf("T4 shmBufferGetSize=%d\n",shmBufferGetSize( index ));
-    printf("T4 getMsgTotalSize=%d\n",getMsgTotalSize());
+
     // copy the local message data to the target location
     if ( shmBufferGetSize( index ) >= getMsgTotalSize() )
-        memcpy( tgt, getMsg(), getMsgTotalSize() );
+    {
+        streamCopy( tgt, getMsg(), getMsgTotalSize() );
+        Framework::shmBufferSetUsedSize( shmBufferGetInfo( index ), getMsgTotalSize() );
+    }
+
+    // mark the end of the data for readers walking the messages of the buffer
+    if ( getMsgTotalSize() + sizeof( RDB_MSG_HDR_t ) <= shmBufferGetSize( index ) )
+        ( ( RDB_MSG_t* ) ( ( ( char* ) tgt ) + getMsgTotalSize() ) )->hdr.magicNo = 0;
 
     return true;
 }
@@ -2648,13 +2882,51 @@ RDBHandler::addMsgToShm( unsigned int index, RDB_MSG_t* msg )
     if ( shmBufferGetSize( index ) < ( usedSize + msgTotalSize ) )
         return false;
     
-    memcpy( ( tgt + usedSize ), msg, msgTotalSize );
+    streamCopy( ( tgt + usedSize ), msg, msgTotalSize );
+    
+    usedSize += msgTotalSize;
+    
+    // mark the end of the data for readers walking the messages of the buffer
+    if ( usedSize + sizeof( RDB_MSG_HDR_t ) <= shmBufferGetSize( index ) )
+        ( ( RDB_MSG_t* ) ( tgt + usedSize ) )->hdr.magicNo = 0;
+    
+    Framework::shmBufferSetUsedSize( shmBufferGetInfo( index ), usedSize );
     
     return true;
 }
 
 unsigned int
 RDBHandler::shmBufferGetUsedSize( unsigned int index )
+{
+    RDB_SHM_BUFFER_INFO_t* info = shmBufferGetInfo( index );
+    
+    if ( !info )
+        return 0;
+    
+    unsigned int usedSize = Framework::shmBufferGetUsedSize( info );
+    
+    // a producer which does not keep the count leaves it at 0, although the buffer holds messages
+    if ( !usedSize )
+    {
+        RDB_MSG_t* msg = ( RDB_MSG_t* ) shmBufferGetPtr( index );
+        
+        if ( msg->hdr.magicNo == RDB_MAGIC_NO )
+            return shmBufferCountUsedSize( index );
+    }
+    
+#ifdef RDB_HANDLER_CHECK_USED_SIZE
+    unsigned int noBytes = shmBufferCountUsedSize( index );
+    
+    if ( noBytes != usedSize )
+        fprintf( stderr, "RDBHandler::shmBufferGetUsedSize: buffer %u holds messages of %u bytes, the count says %u bytes\n",
+                         index, noBytes, usedSize );
+#endif
+    
+    return usedSize;
+}
+
+unsigned int
+RDBHandler::shmBufferCountUsedSize( unsigned int index )
 {
     char* tgt = ( char* ) shmBufferGetPtr( index );
     
@@ -2693,6 +2965,24 @@ RDBHandler::shmBufferClear( unsigned int index, bool force )
     
     memset( tgt, 0, shmBufferGetSize( index ) );
     
+    Framework::shmBufferSetUsedSize( shmBufferGetInfo( index ), 0 );
+    
+    return true;
+}
+
+bool
+RDBHandler::shmBufferReset( unsigned int index )
+{
+    RDB_MSG_t* msg = ( RDB_MSG_t* ) shmBufferGetPtr( index );
+    
+    if ( !msg || ( shmBufferGetSize( index ) < sizeof( RDB_MSG_HDR_t ) ) )
+        return false;
+    
+    // instead of clearing the whole buffer, the end of the data is marked by a header without magic number
+    msg->hdr.magicNo = 0;
+    
+    Framework::shmBufferSetUsedSize( shmBufferGetInfo( index ), 0 );
+    
     return true;
 }
 
@@ -2708,7 +2998,7 @@ RDBHandler::shmBufferIsLocked( unsigned int index )
     //fprintf( stderr, "RDBHandler::shmBufferIsLocked: buffer %d, flags = 0x%x, isLocked = 0x%x\n", 
     //                 index, info->flags, info->flags & RDB_SHM_BUFFER_FLAG_LOCK );
 
-    return ( ( info->flags & RDB_SHM_BUFFER_FLAG_LOCK ) != 0 );
+    return ( ( Framework::shmBufferGetFlags( info ) & RDB_SHM_BUFFER_FLAG_LOCK ) != 0 );
 }
 
 bool
@@ -2719,7 +3009,12 @@ RDBHandler::shmBufferLock( unsigned int index )
     if ( !info )
         return false;
     
-    info->flags |= RDB_SHM_BUFFER_FLAG_LOCK;
+    // checking for the lock and taking it is one transition, so that two parties cannot both succeed
+    if ( !shmBufferTryLock( info ) )
+        return false;
+    
+    // the holder of the lock may alter the contents
+    shmBufferBeginWrite( info );
 
     //fprintf( stderr, "RDBHandler::shmBufferLock: mShmHdr %p locking buffer %d, flags = 0x%x\n", mShmHdr, index, info->flags );
     
@@ -2734,13 +3029,147 @@ RDBHandler::shmBufferRelease( unsigned int index )
     if ( !info )
         return false;
  
-    info->flags &= ~RDB_SHM_BUFFER_FLAG_LOCK;
+    shmBufferEndWrite( info );
+    shmBufferUnlock( info );
     
     //fprintf( stderr, "RDBHandler::shmBufferRelease: mShmHdr %p releasing buffer %d, flags = 0x%x\n", mShmHdr, index, info->flags );
  
     return true;
 }
 
+bool
+RDBHandler::shmBufferHandOver( unsigned int index, unsigned int flags )
+{
+    RDB_SHM_BUFFER_INFO_t* info = shmBufferGetInfo( index );
+    
+    if ( !info )
+        return false;
+    
+    shmBufferEndWrite( info );
+    
+    // the lock is replaced by the flags in one transition, a reader sees either or
+    return shmBufferChangeFlags( info, 0, 0, flags, RDB_SHM_BUFFER_FLAG_LOCK );
+}
+
+RDB_MSG_HDR_t*
+RDBHandler::shmMsgBegin( unsigned int index, const double & simTime, const unsigned int & simFrame, bool append )
+{
+    char* tgt = ( char* ) shmBufferGetPtr( index );
+    
+    if ( !tgt || mShmMsg )
+        return 0;
+    
+    size_t usedSize   = append ? shmBufferGetUsedSize( index ) : 0;
+    size_t bufferSize = shmBufferGetSize( index );
+    
+    if ( usedSize + sizeof( RDB_MSG_HDR_t ) > bufferSize )
+        return 0;
+    
+    mShmMsg          = ( RDB_MSG_t* ) ( tgt + usedSize );
+    mShmMsgIndex     = index;
+    mShmMsgCapacity  = bufferSize - usedSize;
+    mShmLastEntry    = 0;
+    mShmPrevUsedSize = usedSize;
+    
+    // the messages which are replaced become invalid below, so the count must not cover them any more
+    if ( !append )
+        Framework::shmBufferSetUsedSize( shmBufferGetInfo( index ), 0 );
+    
+    // readers walking the buffer stop at this message until it is committed
+    mShmMsg->hdr.magicNo    = 0;
+    mShmMsg->hdr.version    = RDB_VERSION;
+    mShmMsg->hdr.headerSize = sizeof( RDB_MSG_HDR_t );
+    mShmMsg->hdr.dataSize   = 0;
+    mShmMsg->hdr.frameNo    = simFrame;
+    mShmMsg->hdr.simTime    = simTime;
+    
+    return &( mShmMsg->hdr );
+}
+
+void*
+RDBHandler::shmMsgAddPackage( unsigned int pkgId, unsigned int noElements, bool extended, size_t trailingData, 
+                              RDB_MSG_ENTRY_HDR_t** entryHdr )
+{
+    if ( !mShmMsg )
+        return 0;
+    
+    // the buffer cannot grow; the trailing data is not cleared, the caller writes it in place
+    void* data = appendPackage( mShmMsg, mShmMsgCapacity, 0, false, mShmLastEntry, mShmMsg->hdr.simTime, mShmMsg->hdr.frameNo, 
+                                pkgId, noElements, extended, trailingData, false, false );
+    
+    if ( data && entryHdr )
+        *entryHdr = ( RDB_MSG_ENTRY_HDR_t* ) ( ( ( char* ) mShmMsg ) + mShmLastEntry );
+    
+    return data;
+}
+
+RDB_IMAGE_t*
+RDBHandler::shmMsgAddImages( unsigned int noImages, size_t imgSize )
+{
+    RDB_IMAGE_t* images = ( RDB_IMAGE_t* ) shmMsgAddPackage( RDB_PKG_ID_IMAGE, noImages, false, imgSize );
+    
+    if ( !images )
+        return 0;
+    
+    RDB_IMAGE_t* image = images;
+    
+    for ( unsigned int i = 0; i < noImages; i++, image = getNextImage( image ) )
+        image->imgSize = imgSize;
+    
+    return images;
+}
+
+void*
+RDBHandler::getImageData( RDB_IMAGE_t* image )
+{
+    return image + 1;
+}
+
+RDB_IMAGE_t*
+RDBHandler::getNextImage( RDB_IMAGE_t* image )
+{
+    return ( RDB_IMAGE_t* ) ( ( ( char* ) ( image + 1 ) ) + image->imgSize );
+}
+
+bool
+RDBHandler::shmMsgCommit( unsigned int flags )
+{
+    if ( !mShmMsg )
+        return false;
+    
+    size_t                 msgSize = mShmMsg->hdr.headerSize + mShmMsg->hdr.dataSize;
+    
+    // mark the end of the data for readers walking the messages of the buffer
+    if ( msgSize + sizeof( RDB_MSG_HDR_t ) <= mShmMsgCapacity )
+        ( ( RDB_MSG_t* ) ( ( ( char* ) mShmMsg ) + msgSize ) )->hdr.magicNo = 0;
+    
+    // the data may have been written with non-temporal stores, which are not ordered by the release below
+    streamCopyFence();
+    
+    // the message with all its sizes becomes valid at once, the buffer is handed over after it
+    __atomic_store_n( &mShmMsg->hdr.magicNo, ( uint32_t ) RDB_MAGIC_NO, __ATOMIC_RELEASE );
+    
+    Framework::shmBufferSetUsedSize( shmBufferGetInfo( mShmMsgIndex ),
+                                     ( ( char* ) mShmMsg - ( char* ) shmBufferGetPtr( mShmMsgIndex ) ) + msgSize );
+    
+    mShmMsg = 0;
+    
+    return shmBufferHandOver( mShmMsgIndex, flags );
+}
+
+void
+RDBHandler::shmMsgAbort()
+{
+    if ( !mShmMsg )
+        return;
+    
+    // the message remains invalid, so readers do not see any of it; the usage is the one the message has been begun at
+    Framework::shmBufferSetUsedSize( shmBufferGetInfo( mShmMsgIndex ), mShmPrevUsedSize );
+    
+    shmBufferRelease( mShmMsgIndex );
+    
+    mShmMsg = 0;
+}
 
 unsigned int
 RDBHandler::shmGetNoBuffers()
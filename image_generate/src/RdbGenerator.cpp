@@ -0,0 +1,578 @@
+// RdbGenerator.cpp : synthetic producer of RDB image messages, publishing
+// through the SHM writer API of RDBHandler for load tests of image_generate
+// without a simulator
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/shm.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+#include "RDBHandler.hh"
+#include "ShmNotify.hh"
+#include "PixelConvert.hh"
+
+// forward declarations of methods
+
+/**
+* compose the message which is published in every frame: one camera and one image package per camera
+* @return true if successful
+*/
+bool composeMsg();
+
+/**
+* compute the size of the message which is published in every frame
+* @return size of the message
+*/
+size_t getMsgSize();
+
+/**
+* fill the camera packages
+* @param camera     first camera package
+*/
+void fillCameras( RDB_CAMERA_t* camera );
+
+/**
+* fill the header of an image
+* @param img        header of the image
+* @param index      index of the camera the image belongs to
+*/
+void fillImage( RDB_IMAGE_t* img, unsigned int index );
+
+/**
+* convert a value of the gradient rendered into the images to a half float
+* @param value      value in [0, 1]
+* @return half float
+*/
+uint16_t floatToHalf( float value );
+
+/**
+* render the pixels of an image with values matching the channel type of the pixel format
+* @param data       image data
+* @param index      index of the camera the image belongs to
+* @param frameNo    number of the frame
+*/
+void renderImage( uint8_t* data, unsigned int index, unsigned int frameNo );
+
+/**
+* create (or re-use) the SHM segment and configure its buffers
+* @param bufferSize size of a single buffer
+* @return true if successful
+*/
+bool openShm( size_t bufferSize );
+
+/**
+* check whether the next buffer may be written
+* @param userData   unused
+* @return true if the buffer may be written
+*/
+bool shmBufferIsFree( void* userData );
+
+/**
+* stamp the message with the frame and write it into the next SHM buffer
+* @param frameNo    number of the frame
+* @param simTime    simulation time of the frame
+* @return true if successful
+*/
+bool publishFrame( unsigned int frameNo, double simTime );
+
+/**
+* stamp the message composed locally with the frame and copy it into an SHM buffer locked before
+* @param index      index of the buffer
+* @param frameNo    number of the frame
+* @param simTime    simulation time of the frame
+* @return true if successful
+*/
+bool copyToShm( unsigned int index, unsigned int frameNo, double simTime );
+
+/**
+* compose the message of a frame right in an SHM buffer locked before
+* @param index      index of the buffer
+* @param frameNo    number of the frame
+* @param simTime    simulation time of the frame
+* @return true if successful
+*/
+bool composeInShm( unsigned int index, unsigned int frameNo, double simTime );
+
+/**
+* some global variables, considered "members" of this program
+*/
+unsigned int              mShmKey       = 0x08130;              // key of the SHM segment
+unsigned int              mNoBuffers    = 2;                    // number of SHM buffers
+unsigned int              mWidth        = 3840;                 // width of the images
+unsigned int              mHeight       = 2160;                 // height of the images
+const Framework::PIXEL_CONVERSION_t* mFormat = 0;                // pixel format of the images
+unsigned int              mNoCameras    = 4;                    // number of cameras, each with one image per frame
+double                    mFrameRate    = 60.0;                 // frames per second, 0 = as fast as possible
+unsigned int              mBurstSize    = 1;                    // number of frames published back-to-back
+unsigned int              mNoFrames     = 0;                    // number of frames to publish, 0 = endless
+bool                      mLossless     = false;                // wait for the reader instead of overwriting unread buffers?
+bool                      mInPlace      = false;                // compose the frames right in the SHM buffers instead of copying them?
+bool                      mVerbose      = false;                // run in verbose mode?
+volatile sig_atomic_t     mQuit         = 0;                    // set by the signal handler
+
+void*                     mShmPtr       = 0;                    // attached SHM segment
+Framework::RDBHandler     mRdbHandler;                          // the message and the layout of the SHM segment
+RDB_IMAGE_t*              mImages       = 0;                    // image packages within the message
+Framework::ShmDoorbell    mDoorbell;                            // doorbell next to the SHM segment
+Framework::AdaptiveWaiter mWaiter;                              // waiting for the reader to release a buffer
+Framework::TimingStats    mWaitStats;                           // time spent waiting for the reader
+Framework::TimingStats    mLateStats;                           // delay of frames behind their schedule
+Framework::TimingStats    mCopyStats;                           // time of rendering a frame and writing it into the SHM
+unsigned int              mNextBuffer   = 0;                    // buffer which is written next
+uint64_t                  mNoPublished  = 0;                    // number of frames published
+uint64_t                  mNoOverwritten = 0;                   // number of frames overwritten before the reader took them
+
+/**
+* information about usage of the software
+* this method will exit the program
+*/
+void usage()
+{
+    printf("usage: rdbGenerator [-k:key] [-b:noBuffers] [-r:resolution] [-p:pixelFormat] [-c:cameras] [-f:fps] [-u:burst] [-n:frames] [-l] [-i] [-v]\n\n");
+    printf("       -k:key        SHM key that is to be created\n");
+    printf("       -b:noBuffers  number of SHM buffers (default 2)\n");
+    printf("       -r:resolution size of the images as <width>x<height> (default 3840x2160)\n");
+    printf("       -p:pixelFormat pixel format of the images, e.g. rgb8 (default), rgba8, rgb16, red32f, depth32\n");
+    printf("       -c:cameras    number of cameras (default 4)\n");
+    printf("       -f:fps        frame rate, 0 = as fast as possible (default 60)\n");
+    printf("       -u:burst      publish the frames in bursts of the given number back-to-back, keeping the mean frame rate (default 1)\n");
+    printf("       -n:frames     number of frames to publish, 0 = endless (default)\n");
+    printf("       -l            lossless: wait for the reader instead of overwriting buffers it has not taken yet\n");
+    printf("       -i            in place: compose the frames right in the SHM buffers instead of copying them there\n");
+    printf("       -v            run in verbose mode\n");
+    exit(1);
+}
+
+/**
+* validate the arguments given in the command line
+*/
+void ValidateArgs(int argc, char **argv)
+{
+    for( int i = 1; i < argc; i++)
+    {
+        if ((argv[i][0] == '-') || (argv[i][0] == '/'))
+        {
+            switch (tolower(argv[i][1]))
+            {
+                case 'k':        // shared memory key
+                    if ( strlen( argv[i] ) > 3 )
+                        mShmKey = Framework::parseShmKey( &argv[i][3] );
+                    break;
+
+                case 'b':       // number of buffers
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoBuffers = atoi( &argv[i][3] );
+                    if ( !mNoBuffers || ( mNoBuffers > 255 ) )
+                        usage();
+                    break;
+
+                case 'r':       // resolution
+                    if ( ( strlen( argv[i] ) > 3 ) && ( sscanf( &argv[i][3], "%ux%u", &mWidth, &mHeight ) != 2 ) )
+                        usage();
+                    if ( !mWidth || !mHeight || ( mWidth > 65535 ) || ( mHeight > 65535 ) )
+                        usage();
+                    break;
+
+                case 'p':       // pixel format
+                    if ( ( strlen( argv[i] ) > 3 ) && !( mFormat = Framework::findPixelConversion( &argv[i][3] ) ) )
+                        usage();
+                    break;
+
+                case 'c':       // number of cameras
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoCameras = atoi( &argv[i][3] );
+                    if ( !mNoCameras )
+                        usage();
+                    break;
+
+                case 'f':       // frame rate
+                    if ( strlen( argv[i] ) > 3 )
+                        mFrameRate = atof( &argv[i][3] );
+                    if ( mFrameRate < 0.0 )
+                        usage();
+                    break;
+
+                case 'u':       // burst size
+                    if ( strlen( argv[i] ) > 3 )
+                        mBurstSize = atoi( &argv[i][3] );
+                    if ( !mBurstSize )
+                        usage();
+                    break;
+
+                case 'n':       // number of frames
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoFrames = atoi( &argv[i][3] );
+                    break;
+
+                case 'l':       // lossless
+                    mLossless = true;
+                    break;
+
+                case 'i':       // in place
+                    mInPlace = true;
+                    break;
+
+                case 'v':       // verbose mode
+                    mVerbose = true;
+                    break;
+
+                default:
+                    usage();
+                    break;
+            }
+        }
+    }
+
+    if ( !mFormat )
+        mFormat = Framework::findPixelConversion( RDB_PIX_FORMAT_RGB8, 24 );
+
+    fprintf( stderr, "ValidateArgs: key = 0x%x, noBuffers = %u, %u cameras with %ux%u %s, %.1f fps, bursts of %u, %s, %s\n",
+                     mShmKey, mNoBuffers, mNoCameras, mWidth, mHeight, mFormat->name, mFrameRate, mBurstSize,
+                     mLossless ? "lossless" : "overwriting", mInPlace ? "in place" : "copied" );
+}
+
+/**
+* stop generating on SIGINT / SIGTERM so that statistics can be printed
+*/
+void sigHandler( int )
+{
+    mQuit = 1;
+}
+
+/**
+* main program, publishing one frame after the other at the given rate
+*/
+int main(int argc, char* argv[])
+{
+    ValidateArgs(argc, argv);
+
+    signal( SIGINT,  sigHandler );
+    signal( SIGTERM, sigHandler );
+
+    // in place, there is no local copy of the message
+    if ( !mInPlace && !composeMsg() )
+        return 1;
+
+    // room for the terminating header behind the message
+    if ( !openShm( getMsgSize() + sizeof( RDB_MSG_HDR_t ) ) )
+        return 1;
+
+    if ( !mDoorbell.open( mShmKey ) )
+        fprintf( stderr, "RdbGenerator: no doorbell, readers have to poll\n" );
+
+    uint64_t tStart = Framework::monotonicNs();
+
+    for ( unsigned int frame = 1; !mQuit && ( !mNoFrames || ( frame <= mNoFrames ) ); frame++ )
+    {
+        // the first frame of each burst is due at the mean frame rate, the others follow immediately
+        if ( ( mFrameRate > 0.0 ) && !( ( frame - 1 ) % mBurstSize ) )
+        {
+            uint64_t tDue = tStart + ( uint64_t ) ( ( frame - 1 ) / mFrameRate * 1.0e9 );
+            uint64_t tNow = Framework::monotonicNs();
+
+            if ( tNow < tDue )
+                Framework::sleepUntil( tDue );
+            else
+                mLateStats.add( tNow - tDue );
+        }
+
+        if ( !publishFrame( frame, ( frame - 1 ) / ( mFrameRate > 0.0 ? mFrameRate : 60.0 ) ) )
+            break;
+
+        if ( mVerbose && !( mNoPublished % 100 ) )
+        {
+            mCopyStats.print( mInPlace ? "RdbGenerator: render in SHM" : "RdbGenerator: render and copy to SHM" );
+            mWaitStats.print( "RdbGenerator: wait for reader" );
+            mLateStats.print( "RdbGenerator: behind schedule" );
+        }
+    }
+
+    double elapsed  = ( Framework::monotonicNs() - tStart ) * 1.0e-9;
+    double frameMB  = getMsgSize() / 1048576.0;
+
+    mCopyStats.print( mInPlace ? "RdbGenerator: render in SHM" : "RdbGenerator: render and copy to SHM" );
+    mWaitStats.print( "RdbGenerator: wait for reader" );
+    mLateStats.print( "RdbGenerator: behind schedule" );
+
+    fprintf( stderr, "RdbGenerator: %llu frames of %.1f MB in %.2f s: %.1f frames/s, %.1f MB/s, %llu frames overwritten before being read\n",
+                     ( unsigned long long ) mNoPublished, frameMB, elapsed, elapsed > 0.0 ? mNoPublished / elapsed : 0.0,
+                     elapsed > 0.0 ? mNoPublished * frameMB / elapsed : 0.0, ( unsigned long long ) mNoOverwritten );
+
+    // the segment is kept, so that the reader may still take the last frames
+    shmdt( mShmPtr );
+
+    return 0;
+}
+
+bool composeMsg()
+{
+    size_t imgSize = ( size_t ) mWidth * mHeight * ( mFormat->pixelSize / 8 );
+
+    mRdbHandler.initMsg();
+
+    // cameras first: the image packages are added last, so that their pointer remains valid
+    RDB_CAMERA_t* camera = ( RDB_CAMERA_t* ) mRdbHandler.addPackage( 0.0, 0, RDB_PKG_ID_CAMERA, mNoCameras );
+
+    if ( !camera )
+        return false;
+
+    fillCameras( camera );
+
+    mImages = ( RDB_IMAGE_t* ) mRdbHandler.addPackage( 0.0, 0, RDB_PKG_ID_IMAGE, mNoCameras, false, imgSize );
+
+    if ( !mImages )
+        return false;
+
+    RDB_IMAGE_t* img = mImages;
+
+    // all images of the package have the same size, the package header gives the element size
+    for ( unsigned int i = 0; i < mNoCameras; i++, img = Framework::RDBHandler::getNextImage( img ) )
+        fillImage( img, i );
+
+    fprintf( stderr, "RdbGenerator: message of %lu bytes\n", ( unsigned long ) mRdbHandler.getMsgTotalSize() );
+
+    return true;
+}
+
+size_t getMsgSize()
+{
+    size_t imgSize = ( size_t ) mWidth * mHeight * ( mFormat->pixelSize / 8 );
+
+    return sizeof( RDB_MSG_HDR_t ) + 2 * sizeof( RDB_MSG_ENTRY_HDR_t ) +
+           mNoCameras * ( sizeof( RDB_CAMERA_t ) + sizeof( RDB_IMAGE_t ) + imgSize );
+}
+
+void fillCameras( RDB_CAMERA_t* camera )
+{
+    for ( unsigned int i = 0; i < mNoCameras; i++ )
+    {
+        camera[i].id         = i + 1;
+        camera[i].width      = mWidth;
+        camera[i].height     = mHeight;
+        camera[i].clipNear   = 0.5f;
+        camera[i].clipFar    = 1000.0f;
+        camera[i].focalX     = mWidth / 2.0f;
+        camera[i].focalY     = mWidth / 2.0f;
+        camera[i].principalX = mWidth / 2.0f;
+        camera[i].principalY = mHeight / 2.0f;
+    }
+}
+
+void fillImage( RDB_IMAGE_t* img, unsigned int index )
+{
+    img->width       = mWidth;
+    img->height      = mHeight;
+    img->pixelSize   = mFormat->pixelSize;
+    img->pixelFormat = mFormat->pixelFormat;
+    img->cameraId    = index + 1;
+    img->imgSize     = ( size_t ) mWidth * mHeight * ( mFormat->pixelSize / 8 );
+}
+
+uint16_t floatToHalf( float value )
+{
+    // only for the values of the gradient, [0, 1]: too small values become 0, the mantissa is truncated
+    uint32_t bits;
+
+    memcpy( &bits, &value, sizeof( bits ) );
+
+    int exp = ( int ) ( ( bits >> 23 ) & 0xff ) - 112;
+
+    if ( exp <= 0 )
+        return 0;
+
+    return ( uint16_t ) ( ( exp << 10 ) | ( ( bits >> 13 ) & 0x3ff ) );
+}
+
+void renderImage( uint8_t* data, unsigned int index, unsigned int frameNo )
+{
+    // diagonal gradient of the channel values, shifted per camera and frame; the content is irrelevant for the load
+    unsigned int channelBits = mFormat->pixelSize / mFormat->channels;
+    bool         isDepth     = ( mFormat->pixelFormat == RDB_PIX_FORMAT_DEPTH24 ) || ( mFormat->pixelFormat == RDB_PIX_FORMAT_DEPTH_24 ) ||
+                               ( mFormat->pixelFormat == RDB_PIX_FORMAT_DEPTH32 ) || ( mFormat->pixelFormat == RDB_PIX_FORMAT_DEPTH_32 );
+    bool         isFloat     = ( mFormat->channelType == Framework::PIXEL_CHANNEL_F32 ) && !isDepth;
+    size_t       rowValues   = ( size_t ) mWidth * mFormat->channels;
+    unsigned int shift       = 64 * index + frameNo;
+
+    for ( unsigned int y = 0; y < mHeight; y++ )
+    {
+        if ( isFloat && ( channelBits == 32 ) )
+        {
+            float* row = ( float* ) data + y * rowValues;
+
+            for ( size_t x = 0; x < rowValues; x++ )
+                row[ x ] = ( uint8_t ) ( x + y + shift ) / 255.0f;
+        }
+        else if ( isFloat )
+        {
+            uint16_t* row = ( uint16_t* ) data + y * rowValues;
+
+            for ( size_t x = 0; x < rowValues; x++ )
+                row[ x ] = floatToHalf( ( uint8_t ) ( x + y + shift ) / 255.0f );
+        }
+        else if ( mFormat->channelType == Framework::PIXEL_CHANNEL_U16 )
+        {
+            uint16_t* row = ( uint16_t* ) data + y * rowValues;
+
+            for ( size_t x = 0; x < rowValues; x++ )
+                row[ x ] = ( uint16_t ) ( ( uint8_t ) ( x + y + shift ) * 257 );
+        }
+        else
+        {
+            // 8 bit channels, packed pixels and integer depth: any byte pattern is a valid pixel
+            size_t   rowSize = ( size_t ) mWidth * ( mFormat->pixelSize / 8 );
+            uint8_t* row     = data + y * rowSize;
+
+            for ( size_t x = 0; x < rowSize; x++ )
+                row[ x ] = ( uint8_t ) ( x + y + shift );
+        }
+    }
+}
+
+bool openShm( size_t bufferSize )
+{
+    size_t totalSize = sizeof( RDB_SHM_HDR_t ) + mNoBuffers * ( sizeof( RDB_SHM_BUFFER_INFO_t ) + bufferSize );
+    int    shmId     = shmget( mShmKey, totalSize, IPC_CREAT | 0666 );
+
+    if ( shmId < 0 )
+    {
+        perror( "openShm: shmget()" );
+
+        if ( errno == EINVAL )
+            fprintf( stderr, "openShm: an existing segment with key 0x%x is smaller than %lu bytes, remove it with \"ipcrm -M 0x%x\"\n",
+                             mShmKey, ( unsigned long ) totalSize, mShmKey );
+        return false;
+    }
+
+    struct shmid_ds ds;
+
+    // an existing segment may be larger than needed; its buffers are spread over all of it
+    if ( !shmctl( shmId, IPC_STAT, &ds ) && ( ds.shm_segsz > totalSize ) )
+        totalSize = ds.shm_segsz;
+
+    if ( ( mShmPtr = shmat( shmId, 0, 0 ) ) == ( void* ) -1 )
+    {
+        perror( "openShm: shmat()" );
+        mShmPtr = 0;
+        return false;
+    }
+
+    if ( !mRdbHandler.shmConfigure( mShmPtr, mNoBuffers, totalSize ) )
+        return false;
+
+    mRdbHandler.shmHdrUpdate();
+
+    fprintf( stderr, "openShm: key 0x%x, %lu bytes, %u buffers of %lu bytes\n",
+                     mShmKey, ( unsigned long ) totalSize, mNoBuffers, ( unsigned long ) mRdbHandler.shmBufferGetSize( 0 ) );
+
+    return true;
+}
+
+bool shmBufferIsFree( void* )
+{
+    if ( mQuit )
+        return true;
+
+    // a simulator does not wait for a slow reader, it only keeps off a buffer which is being read
+    if ( !mLossless )
+        return !mRdbHandler.shmBufferIsLocked( mNextBuffer );
+
+    return !mRdbHandler.shmBufferHasFlags( mNextBuffer, RDB_SHM_BUFFER_FLAG_TC ) &&
+           !mRdbHandler.shmBufferHasFlags( mNextBuffer, RDB_SHM_BUFFER_FLAG_LOCK );
+}
+
+bool publishFrame( unsigned int frameNo, double simTime )
+{
+    unsigned int index = mNextBuffer;
+    uint64_t     tWait = Framework::monotonicNs();
+
+    // the reader may lock the buffer between finding it free and locking it here
+    do
+    {
+        while ( !mWaiter.wait( shmBufferIsFree, 0, 100000 ) )
+            ;
+
+        if ( mQuit )
+            return false;
+    }
+    while ( !mRdbHandler.shmBufferLock( index ) );
+
+    uint64_t tCopy = Framework::monotonicNs();
+
+    mWaitStats.add( tCopy - tWait );
+
+    // while the buffer is locked, the reader cannot take the frame any more
+    if ( mRdbHandler.shmBufferHasFlags( index, RDB_SHM_BUFFER_FLAG_TC ) )
+        mNoOverwritten++;
+
+    // either way, the buffer is handed to the reader in the end, releasing the lock at the same time
+    if ( !( mInPlace ? composeInShm( index, frameNo, simTime ) : copyToShm( index, frameNo, simTime ) ) )
+        return false;
+
+    mCopyStats.add( Framework::monotonicNs() - tCopy );
+
+    if ( mDoorbell.isOpen() )
+        mDoorbell.ring();
+
+    mNoPublished++;
+    mNextBuffer = ( index + 1 ) % mNoBuffers;
+
+    return true;
+}
+
+bool copyToShm( unsigned int index, unsigned int frameNo, double simTime )
+{
+    // only the stamps change from frame to frame
+    RDB_MSG_t* msg = mRdbHandler.getMsg();
+
+    msg->hdr.frameNo = frameNo;
+    msg->hdr.simTime = simTime;
+
+    RDB_IMAGE_t* img = mImages;
+
+    // the images are rendered in every frame, as a simulator would, before they are copied
+    for ( unsigned int i = 0; i < mNoCameras; i++, img = Framework::RDBHandler::getNextImage( img ) )
+    {
+        img->id = frameNo;
+        renderImage( ( uint8_t* ) Framework::RDBHandler::getImageData( img ), i, frameNo );
+    }
+
+    // the buffers keep the size given by shmConfigure
+    if ( !mRdbHandler.mapMsgToShm( index, false ) )
+    {
+        mRdbHandler.shmBufferRelease( index );
+        return false;
+    }
+
+    return mRdbHandler.shmBufferHandOver( index, RDB_SHM_BUFFER_FLAG_TC );
+}
+
+bool composeInShm( unsigned int index, unsigned int frameNo, double simTime )
+{
+    if ( !mRdbHandler.shmMsgBegin( index, simTime, frameNo ) )
+        return false;
+
+    RDB_CAMERA_t* camera = ( RDB_CAMERA_t* ) mRdbHandler.shmMsgAddPackage( RDB_PKG_ID_CAMERA, mNoCameras );
+    RDB_IMAGE_t*  img    = camera ? mRdbHandler.shmMsgAddImages( mNoCameras, ( size_t ) mWidth * mHeight * ( mFormat->pixelSize / 8 ) ) : 0;
+
+    if ( !img )
+    {
+        mRdbHandler.shmMsgAbort();
+        return false;
+    }
+
+    fillCameras( camera );
+
+    // the images are rendered right into the buffer, as in copy mode in every frame
+    for ( unsigned int i = 0; i < mNoCameras; i++, img = Framework::RDBHandler::getNextImage( img ) )
+    {
+        fillImage( img, i );
+        img->id = frameNo;
+        renderImage( ( uint8_t* ) Framework::RDBHandler::getImageData( img ), i, frameNo );
+    }
+
+    return mRdbHandler.shmMsgCommit( RDB_SHM_BUFFER_FLAG_TC );
+}
@@ -0,0 +1,411 @@
+// RdbReplay.cpp : stand-in for the simulator, republishing a recording
+// made by "image_generate -r:<name>" into an RDB shared memory segment
+// with the buffer handshake of the simulator (TC flag and buffer lock)
+//
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <signal.h>
+#include <errno.h>
+#include <sys/shm.h>
+#include <string.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "RDBHandler.hh"
+#include "ShmNotify.hh"
+#include "FrameRecorder.hh"
+
+// forward declarations of methods
+
+/**
+* create (or re-use) the SHM segment and configure its buffers
+* @param minBufferSize  minimum size of a single buffer
+* @return true if successful
+*/
+bool openShm( size_t minBufferSize );
+
+/**
+* check whether the next buffer has been released by the reader
+* @param userData   unused
+* @return true if the buffer may be written
+*/
+bool shmBufferIsFree( void* userData );
+
+/**
+* copy the messages of a frame into the next SHM buffer and hand it to the reader
+* @param msgs       the messages of the frame
+* @param tDeadline  time after which the frame is dropped if the reader still holds the buffer, 0 = wait for the reader @unit ns
+* @return true if the frame has been published or dropped, false if the replay is to stop
+*/
+bool publishFrame( const std::vector<const RDB_MSG_t*> & msgs, uint64_t tDeadline );
+
+/**
+* some global variables, considered "members" of this program
+*/
+unsigned int              mShmKey       = 0x08130;              // key of the SHM segment
+unsigned int              mNoBuffers    = 2;                    // number of SHM buffers
+size_t                    mBufferSize   = 0;                    // size of a single SHM buffer, 0 = fit the largest frame
+std::string               mRecordName;                          // base name of the recording
+double                    mSpeed        = 1.0;                  // replay speed relative to simulation time, 0 = as fast as possible
+unsigned int              mNoLoops      = 1;                    // number of passes through the recording, 0 = endless
+bool                      mVerbose      = false;                // run in verbose mode?
+volatile sig_atomic_t     mQuit         = 0;                    // set by the signal handler
+
+int                       mShmId        = -1;                   // id of the SHM segment
+void*                     mShmPtr       = 0;                    // attached SHM segment
+Framework::RDBHandler     mRdbHandler;                          // layout of the SHM segment
+Framework::RecordingReader mRecording;                          // the recording which is replayed
+Framework::ShmDoorbell    mDoorbell;                            // doorbell next to the SHM segment
+Framework::AdaptiveWaiter mWaiter;                              // waiting for the reader to release a buffer
+Framework::TimingStats    mWaitStats;                           // time spent waiting for the reader
+Framework::TimingStats    mLateStats;                           // delay of frames behind their schedule
+unsigned int              mNextBuffer   = 0;                    // buffer which is written next
+uint32_t                  mFrameOffset  = 0;                    // added to the frame numbers, increasing with every loop
+double                    mSimTimeOffset = 0.0;                 // added to the simulation times, increasing with every loop
+uint64_t                  mNoFrames     = 0;                    // number of frames published
+uint64_t                  mNoMessages   = 0;                    // number of messages published
+uint64_t                  mNoBytes      = 0;                    // number of bytes published
+uint64_t                  mNoTruncated  = 0;                    // number of frames exceeding the buffer size
+uint64_t                  mNoDropped    = 0;                    // number of frames dropped because the reader fell behind the pace
+
+/**
+* information about usage of the software
+* this method will exit the program
+*/
+void usage()
+{
+    printf("usage: rdbReplay -r:recording [-k:key] [-b:noBuffers] [-s:bufferSize] [-x:pace] [-l:loops] [-v]\n\n");
+    printf("       -r:recording  base name of the recording (recording_<n>.rdbrec + recording.rdbidx)\n");
+    printf("       -k:key        SHM key that is to be created\n");
+    printf("       -b:noBuffers  number of SHM buffers (default 2)\n");
+    printf("       -s:bufferSize size of a single SHM buffer in MB (default: the largest frame of the recording)\n");
+    printf("       -x:pace       realtime (default), a factor N (N times real time) or max (as fast as the reader takes the frames);\n");
+    printf("                     a paced replay drops the frames the reader cannot take in time, max is lossless\n");
+    printf("       -l:loops      number of passes through the recording, 0 = endless (default 1)\n");
+    printf("       -v            run in verbose mode\n");
+    exit(1);
+}
+
+/**
+* validate the arguments given in the command line
+*/
+void ValidateArgs(int argc, char **argv)
+{
+    for( int i = 1; i < argc; i++)
+    {
+        if ((argv[i][0] == '-') || (argv[i][0] == '/'))
+        {
+            switch (tolower(argv[i][1]))
+            {
+                case 'k':        // shared memory key
+                    if ( strlen( argv[i] ) > 3 )
+                        mShmKey = Framework::parseShmKey( &argv[i][3] );
+                    break;
+
+                case 'b':       // number of buffers
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoBuffers = atoi( &argv[i][3] );
+                    if ( !mNoBuffers || ( mNoBuffers > 255 ) )
+                        usage();
+                    break;
+
+                case 's':       // buffer size
+                    if ( strlen( argv[i] ) > 3 )
+                        mBufferSize = ( size_t ) atoi( &argv[i][3] ) << 20;
+                    break;
+
+                case 'r':       // recording
+                    if ( strlen( argv[i] ) > 3 )
+                        mRecordName = &argv[i][3];
+                    break;
+
+                case 'x':       // pace
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        if ( !strcmp( &argv[i][3], "realtime" ) )
+                            mSpeed = 1.0;
+                        else if ( !strcmp( &argv[i][3], "max" ) )
+                            mSpeed = 0.0;
+                        else if ( ( mSpeed = atof( &argv[i][3] ) ) <= 0.0 )
+                            usage();
+                    }
+                    break;
+
+                case 'l':       // number of loops
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoLoops = atoi( &argv[i][3] );
+                    break;
+
+                case 'v':       // verbose mode
+                    mVerbose = true;
+                    break;
+
+                default:
+                    usage();
+                    break;
+            }
+        }
+    }
+
+    if ( mRecordName.empty() )
+        usage();
+
+    fprintf( stderr, "ValidateArgs: key = 0x%x, noBuffers = %u, recording = %s, speed = %.2f, loops = %u\n",
+                     mShmKey, mNoBuffers, mRecordName.c_str(), mSpeed, mNoLoops );
+}
+
+/**
+* stop replaying on SIGINT / SIGTERM so that statistics can be printed
+*/
+void sigHandler( int )
+{
+    mQuit = 1;
+}
+
+/**
+* main program, publishing one frame of the recording after the other
+*/
+int main(int argc, char* argv[])
+{
+    ValidateArgs(argc, argv);
+
+    signal( SIGINT,  sigHandler );
+    signal( SIGTERM, sigHandler );
+
+    if ( !mRecording.open( mRecordName ) )
+    {
+        fprintf( stderr, "failed to open recording %s\n", mRecordName.c_str() );
+        return 1;
+    }
+
+    uint32_t firstFrame = 0;
+    uint32_t lastFrame  = 0;
+
+    mRecording.getFrameRange( firstFrame, lastFrame );
+
+    fprintf( stderr, "RdbReplay: %lu messages of frames %u..%u, largest frame %lu bytes\n",
+                     ( unsigned long ) mRecording.getNoMessages(), firstFrame, lastFrame, ( unsigned long ) mRecording.getMaxFrameSize() );
+
+    if ( !mRecording.getNoMessages() )
+    {
+        fprintf( stderr, "RdbReplay: recording %s holds no frames\n", mRecordName.c_str() );
+        return 1;
+    }
+
+    if ( !openShm( mRecording.getMaxFrameSize() ) )
+        return 1;
+
+    if ( !mDoorbell.open( mShmKey ) )
+        fprintf( stderr, "RdbReplay: no doorbell, readers have to poll\n" );
+
+    std::vector<const RDB_MSG_t*> msgs;
+
+    uint64_t tStart  = Framework::monotonicNs();
+    double   simStep = 0.0;                 // mean distance of the frames of the last loop, 0 = unknown
+
+    for ( unsigned int loop = 0; !mQuit && ( !mNoLoops || ( loop < mNoLoops ) ); loop++ )
+    {
+        uint64_t tLoop        = Framework::monotonicNs();
+        double   firstSimTime = 0.0;
+        double   lastSimTime  = 0.0;
+        uint64_t noFrames     = 0;
+        uint64_t tDeadline    = 0;
+
+        mRecording.rewind();
+
+        while ( !mQuit && mRecording.nextFrame( msgs ) )
+        {
+            double simTime = msgs[0]->hdr.simTime;
+
+            if ( !noFrames )
+                firstSimTime = simTime;
+
+            // keep the schedule of the simulation, scaled by the speed
+            if ( mSpeed > 0.0 )
+            {
+                uint64_t tDue = tLoop + ( uint64_t ) ( ( simTime - firstSimTime ) / mSpeed * 1.0e9 );
+                uint64_t tNow = Framework::monotonicNs();
+
+                if ( tNow < tDue )
+                    Framework::sleepUntil( tDue );
+                else
+                    mLateStats.add( tNow - tDue );
+
+                // like the simulator, the replay does not wait for a slow reader; a frame is dropped
+                // once the next one would be due, estimated by the distance to the previous frame
+                double step = noFrames ? simTime - lastSimTime : simStep;
+
+                tDeadline = ( step > 0.0 ) ? tDue + ( uint64_t ) ( step / mSpeed * 1.0e9 ) : 0;
+            }
+
+            if ( !publishFrame( msgs, tDeadline ) )
+                break;
+
+            lastSimTime = simTime;
+            noFrames++;
+
+            if ( mVerbose && !( mNoFrames % 100 ) )
+            {
+                mWaitStats.print( "RdbReplay: wait for reader" );
+                mLateStats.print( "RdbReplay: behind schedule" );
+            }
+        }
+
+        // a recording whose frames cannot be read would otherwise be looped through without end
+        if ( !noFrames )
+        {
+            if ( !mQuit )
+                fprintf( stderr, "RdbReplay: no frame could be read from recording %s\n", mRecordName.c_str() );
+            break;
+        }
+
+        // the reader drops frames numbered lower than the last one read, so each loop continues the numbering
+        mFrameOffset   += lastFrame - firstFrame + 1;
+        simStep         = ( noFrames > 1 ) ? ( lastSimTime - firstSimTime ) / ( noFrames - 1 ) : 0.0;
+        mSimTimeOffset += ( lastSimTime - firstSimTime ) + simStep;
+    }
+
+    double elapsed = ( Framework::monotonicNs() - tStart ) * 1.0e-9;
+
+    mWaitStats.print( "RdbReplay: wait for reader" );
+    mLateStats.print( "RdbReplay: behind schedule" );
+
+    fprintf( stderr, "RdbReplay: %llu frames, %llu messages, %.1f MB in %.2f s: %.1f frames/s, %.1f MB/s, %llu frames truncated, %llu dropped\n",
+                     ( unsigned long long ) mNoFrames, ( unsigned long long ) mNoMessages, mNoBytes / 1048576.0, elapsed,
+                     elapsed > 0.0 ? mNoFrames / elapsed : 0.0, elapsed > 0.0 ? mNoBytes / 1048576.0 / elapsed : 0.0,
+                     ( unsigned long long ) mNoTruncated, ( unsigned long long ) mNoDropped );
+
+    // the segment is kept, so that the reader may still take the last frames
+    shmdt( mShmPtr );
+
+    return 0;
+}
+
+bool openShm( size_t minBufferSize )
+{
+    if ( !mBufferSize )
+        mBufferSize = minBufferSize + sizeof( RDB_MSG_HDR_t );      // room for the terminating header
+
+    size_t totalSize = sizeof( RDB_SHM_HDR_t ) + mNoBuffers * ( sizeof( RDB_SHM_BUFFER_INFO_t ) + mBufferSize );
+
+    if ( ( mShmId = shmget( mShmKey, totalSize, IPC_CREAT | 0666 ) ) < 0 )
+    {
+        perror( "openShm: shmget()" );
+
+        if ( errno == EINVAL )
+            fprintf( stderr, "openShm: an existing segment with key 0x%x is smaller than %lu bytes, remove it with \"ipcrm -M 0x%x\"\n",
+                             mShmKey, ( unsigned long ) totalSize, mShmKey );
+        return false;
+    }
+
+    struct shmid_ds ds;
+
+    // an existing segment may be larger than needed; its buffers are spread over all of it
+    if ( !shmctl( mShmId, IPC_STAT, &ds ) && ( ds.shm_segsz > totalSize ) )
+        totalSize = ds.shm_segsz;
+
+    if ( ( mShmPtr = shmat( mShmId, 0, 0 ) ) == ( void* ) -1 )
+    {
+        perror( "openShm: shmat()" );
+        mShmPtr = 0;
+        return false;
+    }
+
+    if ( !mRdbHandler.shmConfigure( mShmPtr, mNoBuffers, totalSize ) )
+        return false;
+
+    mRdbHandler.shmHdrUpdate();
+
+    mBufferSize = mRdbHandler.shmBufferGetSize( 0 );
+
+    fprintf( stderr, "openShm: key 0x%x, %lu bytes, %u buffers of %lu bytes\n",
+                     mShmKey, ( unsigned long ) totalSize, mNoBuffers, ( unsigned long ) mBufferSize );
+
+    return true;
+}
+
+bool shmBufferIsFree( void* )
+{
+    if ( mQuit )
+        return true;
+
+    return !mRdbHandler.shmBufferHasFlags( mNextBuffer, RDB_SHM_BUFFER_FLAG_TC ) &&
+           !mRdbHandler.shmBufferHasFlags( mNextBuffer, RDB_SHM_BUFFER_FLAG_LOCK );
+}
+
+bool publishFrame( const std::vector<const RDB_MSG_t*> & msgs, uint64_t tDeadline )
+{
+    unsigned int index = mNextBuffer;
+    uint64_t     tWait = Framework::monotonicNs();
+
+    // the buffers are written in turn, each one only after the reader has taken it (or released it as stale)
+    while ( 1 )
+    {
+        unsigned int timeoutUs = 100000;
+
+        if ( tDeadline )
+        {
+            uint64_t tNow = Framework::monotonicNs();
+
+            // the frame is dropped, the buffer is written with the next one
+            if ( tNow >= tDeadline )
+            {
+                mWaitStats.add( tNow - tWait );
+                mNoDropped++;
+                return true;
+            }
+
+            timeoutUs = ( unsigned int ) std::min<uint64_t>( ( tDeadline - tNow ) / 1000 + 1, timeoutUs );
+        }
+
+        if ( !mWaiter.wait( shmBufferIsFree, 0, timeoutUs ) )
+            continue;
+
+        if ( mQuit )
+            return false;
+
+        // the reader may still lock the buffer between finding it free and locking it here
+        if ( mRdbHandler.shmBufferLock( index ) )
+            break;
+    }
+
+    mWaitStats.add( Framework::monotonicNs() - tWait );
+
+    char*        buffer = ( char* ) mRdbHandler.shmBufferGetPtr( index );
+    unsigned int used   = 0;
+
+    mRdbHandler.shmBufferReset( index );
+
+    for ( size_t i = 0; i < msgs.size(); i++ )
+    {
+        if ( !mRdbHandler.addMsgToShm( index, ( RDB_MSG_t* ) msgs[i] ) )
+        {
+            mNoTruncated++;
+            break;
+        }
+
+        RDB_MSG_t* msg = ( RDB_MSG_t* ) ( buffer + used );
+
+        msg->hdr.frameNo += mFrameOffset;
+        msg->hdr.simTime += mSimTimeOffset;
+
+        used += msg->hdr.headerSize + msg->hdr.dataSize;
+
+        mNoMessages++;
+    }
+
+    mNoBytes += used;
+    mNoFrames++;
+
+    // hand the buffer to the reader, releasing the lock at the same time
+    mRdbHandler.shmBufferHandOver( index, RDB_SHM_BUFFER_FLAG_TC );
+
+    if ( mDoorbell.isOpen() )
+        mDoorbell.ring();
+
+    mNextBuffer = ( index + 1 ) % mNoBuffers;
+
+    return true;
+}
@@ -0,0 +1,103 @@
+/* ===================================================
+ *  file:       ShmBuffer.cc
+ * ---------------------------------------------------
+ *  purpose:	lock-free ownership protocol of the
+ *              buffers of an RDB shared memory segment
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include "ShmBuffer.hh"
+
+namespace Framework
+{
+
+uint32_t
+shmBufferGetFlags( const RDB_SHM_BUFFER_INFO_t* info )
+{
+    return __atomic_load_n( &info->flags, __ATOMIC_ACQUIRE );
+}
+
+bool
+shmBufferChangeFlags( RDB_SHM_BUFFER_INFO_t* info, uint32_t requireAny, uint32_t requireClear,
+                      uint32_t set, uint32_t clear, uint32_t* prevFlags )
+{
+    uint32_t flags = __atomic_load_n( &info->flags, __ATOMIC_ACQUIRE );
+
+    while ( 1 )
+    {
+        if ( prevFlags )
+            *prevFlags = flags;
+
+        if ( ( requireAny && !( flags & requireAny ) ) || ( flags & requireClear ) )
+            return false;
+
+        // on failure, the flags found are loaded and checked again
+        if ( __atomic_compare_exchange_n( &info->flags, &flags, ( flags | set ) & ~clear, false,
+                                          __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) )
+            return true;
+    }
+}
+
+bool
+shmBufferTryLock( RDB_SHM_BUFFER_INFO_t* info, uint32_t checkMask )
+{
+    return shmBufferChangeFlags( info, checkMask, RDB_SHM_BUFFER_FLAG_LOCK, RDB_SHM_BUFFER_FLAG_LOCK, 0 );
+}
+
+void
+shmBufferUnlock( RDB_SHM_BUFFER_INFO_t* info, uint32_t clear )
+{
+    shmBufferChangeFlags( info, 0, 0, 0, RDB_SHM_BUFFER_FLAG_LOCK | clear );
+}
+
+void
+shmBufferBeginWrite( RDB_SHM_BUFFER_INFO_t* info )
+{
+    uint32_t* generation = &info->spare1[ SHM_BUFFER_GENERATION ];
+
+    // only the producer writes the generation; the contents must not be written before it is odd
+    __atomic_store_n( generation, ( *generation | 1 ), __ATOMIC_RELAXED );
+    __atomic_thread_fence( __ATOMIC_RELEASE );
+}
+
+void
+shmBufferEndWrite( RDB_SHM_BUFFER_INFO_t* info )
+{
+    uint32_t* generation = &info->spare1[ SHM_BUFFER_GENERATION ];
+
+    __atomic_store_n( generation, ( *generation | 1 ) + 1, __ATOMIC_RELEASE );
+}
+
+uint32_t
+shmBufferGetUsedSize( const RDB_SHM_BUFFER_INFO_t* info )
+{
+    return __atomic_load_n( &info->spare1[ SHM_BUFFER_USED_SIZE ], __ATOMIC_ACQUIRE );
+}
+
+void
+shmBufferSetUsedSize( RDB_SHM_BUFFER_INFO_t* info, uint32_t size )
+{
+    __atomic_store_n( &info->spare1[ SHM_BUFFER_USED_SIZE ], size, __ATOMIC_RELEASE );
+}
+
+bool
+shmBufferBeginRead( const RDB_SHM_BUFFER_INFO_t* info, uint32_t & generation )
+{
+    generation = __atomic_load_n( &info->spare1[ SHM_BUFFER_GENERATION ], __ATOMIC_ACQUIRE );
+
+    return !( generation & 1 );
+}
+
+bool
+shmBufferCheckRead( const RDB_SHM_BUFFER_INFO_t* info, uint32_t generation )
+{
+    // the reads of the contents must be done before the generation is read again
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+
+    return __atomic_load_n( &info->spare1[ SHM_BUFFER_GENERATION ], __ATOMIC_RELAXED ) == generation;
+}
+
+} // namespace Framework
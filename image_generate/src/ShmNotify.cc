@@ -0,0 +1,320 @@
+/* ===================================================
+ *  file:       ShmNotify.cc
+ * ---------------------------------------------------
+ *  purpose:	wake-up notification for readers of an
+ *              RDB shared memory segment
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include "ShmNotify.hh"
+#include "viRDBIcd.h"
+
+namespace Framework
+{
+
+static inline void
+cpuRelax()
+{
+#if defined( __x86_64__ ) || defined( __i386__ )
+    __builtin_ia32_pause();
+#endif
+}
+
+uint64_t
+monotonicNs()
+{
+    struct timespec ts;
+
+    clock_gettime( CLOCK_MONOTONIC, &ts );
+
+    return ( uint64_t ) ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+bool
+sleepUntil( uint64_t timeNs )
+{
+    struct timespec ts;
+
+    ts.tv_sec  = timeNs / 1000000000ull;
+    ts.tv_nsec = timeNs % 1000000000ull;
+
+    return clock_nanosleep( CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, 0 ) == 0;
+}
+
+unsigned int
+parseShmKey( const char* text, char** end )
+{
+    bool hex = ( text[0] == '0' ) && ( ( text[1] == 'x' ) || ( text[1] == 'X' ) );
+
+    return strtoul( text, end, hex ? 16 : 10 );
+}
+
+ShmDoorbell::ShmDoorbell() : mBell( 0 )
+{
+}
+
+ShmDoorbell::~ShmDoorbell()
+{
+    close();
+}
+
+std::string
+ShmDoorbell::name( unsigned int shmKey )
+{
+    char name[64];
+
+    snprintf( name, sizeof( name ), "/rdb_doorbell_0x%x", shmKey );
+
+    return std::string( name );
+}
+
+bool
+ShmDoorbell::open( unsigned int shmKey )
+{
+    if ( mBell )
+        return true;
+
+    // producer and reader may come up in any order, so both sides create the object
+    int fd = shm_open( name( shmKey ).c_str(), O_RDWR | O_CREAT, 0666 );
+
+    if ( fd < 0 )
+    {
+        perror( "ShmDoorbell::open: shm_open()" );
+        return false;
+    }
+
+    struct stat st;
+
+    if ( ( fstat( fd, &st ) < 0 ) || ( ( st.st_size < ( off_t ) sizeof( RDB_SHM_DOORBELL_t ) ) && ( ftruncate( fd, sizeof( RDB_SHM_DOORBELL_t ) ) < 0 ) ) )
+    {
+        perror( "ShmDoorbell::open: ftruncate()" );
+        ::close( fd );
+        return false;
+    }
+
+    void* ptr = mmap( 0, sizeof( RDB_SHM_DOORBELL_t ), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0 );
+
+    ::close( fd );
+
+    if ( ptr == MAP_FAILED )
+    {
+        perror( "ShmDoorbell::open: mmap()" );
+        return false;
+    }
+
+    mBell = ( RDB_SHM_DOORBELL_t* ) ptr;
+
+    // a freshly created object is zero-filled
+    uint32_t expected = 0;
+    __atomic_compare_exchange_n( &mBell->magicNo, &expected, ( uint32_t ) RDB_MAGIC_NO, false, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE );
+
+    return true;
+}
+
+void
+ShmDoorbell::close()
+{
+    if ( !mBell )
+        return;
+
+    munmap( mBell, sizeof( RDB_SHM_DOORBELL_t ) );
+
+    mBell = 0;
+}
+
+bool
+ShmDoorbell::isOpen() const
+{
+    return mBell != 0;
+}
+
+bool
+ShmDoorbell::hasRung() const
+{
+    if ( !mBell )
+        return false;
+
+    return __atomic_load_n( &mBell->seq, __ATOMIC_ACQUIRE ) != 0;
+}
+
+uint32_t
+ShmDoorbell::getSeq() const
+{
+    if ( !mBell )
+        return 0;
+
+    return __atomic_load_n( &mBell->seq, __ATOMIC_ACQUIRE );
+}
+
+void
+ShmDoorbell::ring()
+{
+    if ( !mBell )
+        return;
+
+    __atomic_store_n( &mBell->ringTime, monotonicNs(), __ATOMIC_RELAXED );
+    __atomic_add_fetch( &mBell->seq, 1, __ATOMIC_RELEASE );
+
+    // only pay for the syscall if somebody is actually sleeping
+    if ( __atomic_load_n( &mBell->waiters, __ATOMIC_SEQ_CST ) )
+        syscall( SYS_futex, &mBell->seq, FUTEX_WAKE, INT_MAX, 0, 0, 0 );
+}
+
+bool
+ShmDoorbell::wait( uint32_t & lastSeq, unsigned int timeoutUs )
+{
+    if ( !mBell )
+        return false;
+
+    uint32_t seq = __atomic_load_n( &mBell->seq, __ATOMIC_ACQUIRE );
+
+    if ( seq == lastSeq )
+    {
+        struct timespec timeout;
+
+        timeout.tv_sec  = timeoutUs / 1000000;
+        timeout.tv_nsec = ( timeoutUs % 1000000 ) * 1000;
+
+        __atomic_add_fetch( &mBell->waiters, 1, __ATOMIC_SEQ_CST );
+
+        // the kernel re-checks the futex word, so a ring between load and wait is not lost
+        if ( syscall( SYS_futex, &mBell->seq, FUTEX_WAIT, lastSeq, &timeout, 0, 0 ) < 0 )
+        {
+            if ( ( errno != ETIMEDOUT ) && ( errno != EAGAIN ) && ( errno != EINTR ) )
+                perror( "ShmDoorbell::wait: futex()" );
+        }
+
+        __atomic_sub_fetch( &mBell->waiters, 1, __ATOMIC_SEQ_CST );
+
+        seq = __atomic_load_n( &mBell->seq, __ATOMIC_ACQUIRE );
+    }
+
+    bool rung = ( seq != lastSeq );
+
+    lastSeq = seq;
+
+    return rung;
+}
+
+uint64_t
+ShmDoorbell::lastRingTime() const
+{
+    if ( !mBell )
+        return 0;
+
+    return __atomic_load_n( &mBell->ringTime, __ATOMIC_RELAXED );
+}
+
+AdaptiveWaiter::AdaptiveWaiter( unsigned int maxSpinUs, unsigned int maxSleepUs ) : mMaxSpinUs( maxSpinUs ),
+                                                                                     mMaxSleepUs( maxSleepUs ),
+                                                                                     mSpinUs( maxSpinUs ),
+                                                                                     mLastMiss( 0 )
+{
+}
+
+bool
+AdaptiveWaiter::wait( ReadyFunc ready, void* userData, unsigned int timeoutUs )
+{
+    uint64_t start    = monotonicNs();
+    uint64_t spinEnd  = start + mSpinUs * 1000ull;
+    uint64_t yieldEnd = spinEnd + 50000ull;
+    uint64_t deadline = timeoutUs ? ( start + timeoutUs * 1000ull ) : 0;
+
+    unsigned int sleepUs = 20;
+
+    // data which is already waiting counts as detected without delay
+    mLastMiss = start;
+
+    while ( 1 )
+    {
+        uint64_t now = monotonicNs();
+
+        if ( ready( userData ) )
+        {
+            // data arrived before we went to sleep: spinning pays off, allow more of it;
+            // otherwise the producer is slow and spinning only burns the CPU
+            if ( now < yieldEnd )
+                mSpinUs = ( mSpinUs * 2 > mMaxSpinUs ) ? mMaxSpinUs : ( mSpinUs ? mSpinUs * 2 : 1 );
+            else
+                mSpinUs /= 2;
+
+            return true;
+        }
+
+        mLastMiss = now;
+
+        if ( deadline && ( now >= deadline ) )
+            return false;
+
+        if ( now < spinEnd )
+        {
+            for ( int i = 0; i < 64; i++ )
+                cpuRelax();
+        }
+        else if ( now < yieldEnd )
+            sched_yield();
+        else
+        {
+            usleep( sleepUs );
+
+            sleepUs = ( sleepUs * 2 > mMaxSleepUs ) ? mMaxSleepUs : sleepUs * 2;
+        }
+    }
+}
+
+uint64_t
+AdaptiveWaiter::lastMissTime() const
+{
+    return mLastMiss;
+}
+
+TimingStats::TimingStats() : mCount( 0 ),
+                             mSumNs( 0 ),
+                             mMinNs( 0 ),
+                             mMaxNs( 0 )
+{
+}
+
+void
+TimingStats::add( uint64_t durationNs )
+{
+    if ( !mCount || ( durationNs < mMinNs ) )
+        mMinNs = durationNs;
+
+    if ( durationNs > mMaxNs )
+        mMaxNs = durationNs;
+
+    mSumNs += durationNs;
+    mCount++;
+}
+
+void
+TimingStats::print( const char* label, bool reset )
+{
+    if ( mCount )
+        fprintf( stderr, "%s over %llu frames: min = %.1f us, avg = %.1f us, max = %.1f us\n",
+                         label, ( unsigned long long ) mCount, mMinNs * 1.0e-3, ( mSumNs * 1.0e-3 ) / mCount, mMaxNs * 1.0e-3 );
+    else
+        fprintf( stderr, "%s: no frames\n", label );
+
+    if ( reset )
+        *this = TimingStats();
+}
+
+} // namespace Framework
@@ -8,26 +8,114 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <signal.h>
 #include <sys/shm.h>
+#include <sys/stat.h>
 #include <string.h>
 #include <unistd.h>
+#include <errno.h>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
 #include <cstring>
 #include <sstream>
+#include <algorithm>
+#include <map>
+#include <vector>
 #include "RDBHandler.hh"
+#include "ShmNotify.hh"
+#include "ShmSegment.hh"
+#include "ShmBuffer.hh"
+#include "FrameEncoder.hh"
+#include "CameraLanes.hh"
+#include "FrameRecorder.hh"
+#include "PixelConvert.hh"
+#include "PointCloud.hh"
+#include "LatencyStats.hh"
+#include "AsyncLog.hh"
+#include "ThreadTuning.hh"
+#include "StreamCopy.hh"
+#include "FrameRing.hh"
 #include <opencv2/opencv.hpp>
 #include <opencv2/core/core.hpp>
 #include <opencv2/highgui/highgui.hpp>
 
+#define SHM_GENERATION_CHECK_NS  250000000ull     // interval of checking a silent segment for a restart of the producer @unit ns
+#define SHM_ATTACH_RETRY_NS      10000000ull      // interval of trying to attach a segment which is missing           @unit ns
+#define DOORBELL_SILENCE_NS      1000000000ull    // a doorbell not rung for this long is not waited for any more                      @unit ns
+
+/**
+* an SHM segment watched by the reader and the state of reading it; each segment has lanes of
+* its own, since different producers may use the same camera ids
+*/
+struct ShmSource
+{
+    unsigned int              key;              // key of the SHM segment
+    std::string               label;            // label of the messages and statistics of the segment
+    Framework::ShmSegment     shm;              // the attached SHM segment and its buffer table
+    unsigned int              noFramesRead;     // number of SHM buffers which have been processed
+    unsigned int              noBuffersSkipped; // number of stale SHM buffers released without reading
+    unsigned int              lastFrameNo;      // frame number of the last buffer read
+    double                    lastSimTime;      // simulation time of the last buffer read                            @unit s
+    double                    startSimTime;     // simulation time of the first buffer read since the (re)start       @unit s
+    uint64_t                  tLastGeneration;  // time frames were read or the generation was checked last         @unit ns
+    uint64_t                  tDetached;        // time the segment was found removed or replaced, 0 if not         @unit ns
+    uint64_t                  tNextAttach;      // time of the next attempt to attach while the segment is missing  @unit ns
+    Framework::CameraRouter   lanes;            // per-camera queues writing images
+    std::map<uint16_t, RDB_CAMERA_t>              cameras;      // latest camera package per camera id
+    std::map<uint16_t, Framework::DepthProjector> projectors;   // back-projection per camera id
+
+    explicit ShmSource( unsigned int shmKey ) : key( shmKey ),
+                                                noFramesRead( 0 ),
+                                                noBuffersSkipped( 0 ),
+                                                lastFrameNo( 0 ),
+                                                lastSimTime( 0.0 ),
+                                                startSimTime( 0.0 ),
+                                                tLastGeneration( 0 ),
+                                                tDetached( 0 ),
+                                                tNextAttach( 0 )
+    {
+    }
+};
+
 // forward declarations of methods
 
 /**
 * method for checking the contents of the SHM
 */
-int  checkShm();
-void openShm();
+int  checkShm( ShmSource & source );
+void openShm( ShmSource & source );
+
+/**
+* read a segment if it holds a new frame, attach it if it is missing, and check whether
+* the producer has been restarted if it stays silent; called by the scheduler for each
+* segment in turn
+* @param source the segment
+* @param tWake  time the scheduler woke up
+*/
+void serveShm( ShmSource & source, uint64_t tWake );
+
+/**
+* detach from a segment after the producer has removed or replaced it; it is attached
+* again by serveShm(), the encoders, lanes and the recording are kept
+* @param source the segment
+* @param tWake  time the scheduler woke up
+*/
+void reattachShm( ShmSource & source, uint64_t tWake );
+
+/**
+* cheap check whether any SHM buffer of any segment is ready for reading (no locking, no
+* processing), or a missing segment is to be attached
+* @param userData   unused
+* @return true if a segment needs to be served
+*/
+bool shmHasData( void* userData );
+
+/**
+* wait until the next SHM check is due, according to the wait mode
+* @return true if the wait was ended by the producer's doorbell
+*/
+bool waitForShm();
 
 /**
 * routine for handling an RDB message; to be provided by user;
@@ -52,29 +140,133 @@ void parseRDBMessageEntry( const double & simTime, const unsigned int & simFrame
  */
 void handleRDBitem(const double & simTime, const unsigned int & simFrame, RDB_IMAGE_t* img, int counter);
 
+/**
+ * Handle a RDBCamera, keep it for the back-projection of depth images
+ * @param simTime
+ * @param simFrame
+ * @param camera
+ */
+void handleRDBitem(const double & simTime, const unsigned int & simFrame, RDB_CAMERA_t* camera);
+
+/**
+ * Publish an image or point cloud to the local consumers of the frame ring
+ * @param slot        slot of the ring, 0 if the frame is not published
+ * @param data        the converted frame, 0 if it has been converted into the slot right away
+ * @param simTime
+ * @param simFrame
+ * @param img         image header as received
+ * @param channels    number of channels of the converted frame
+ * @param channelType type of the channels, PIXEL_CHANNEL_...
+ * @param pointCloud  0 = image, 1 = interleaved points, 2 = point planes
+ */
+void publishFrame( Framework::FRAME_RING_SLOT_t* slot, const char* data, const double & simTime, const unsigned int & simFrame,
+                   const RDB_IMAGE_t* img, int channels, int channelType, int pointCloud );
+
+/**
+ * Write an image or point cloud which has been converted out of the SHM; runs in an encoder thread
+ * @param frame
+ */
+void encodeImageFrame( Framework::ImageFrame* frame );
+
 /**
 * some global variables, considered "members" of this example
 */
 // unsigned int mShmKey       = 0x8201;                            // key of the SHM segment
 // unsigned int mShmKey       = 0x816a;                            // key of the SHM segment
-unsigned int mShmKey       = 0x08130;                            // key of the SHM segment
+std::vector<unsigned int> mShmKeys( 1, 0x08130 );                // keys of the SHM segments
 unsigned int mCheckMask    = RDB_SHM_BUFFER_FLAG_TC;
-void*        mShmPtr       = 0;                                 // pointer to the SHM segment
-size_t       mShmTotalSize = 0;                                 // remember the total size of the SHM segment
+std::vector<ShmSource*> mSources;                               // the watched SHM segments, one per key
+ShmSource*   mSource       = 0;                                 // segment being read by checkShm()
 bool         mVerbose      = false;                             // run in verbose mode?
 int          mForceBuffer  = -1;                                // force reading one of the SHM buffers (0=A, 1=B)
 
+/**
+* ways of waiting for the next frame
+*/
+enum WaitMode
+{
+    WAIT_MODE_POLL,         // fixed 1 ms polling interval
+    WAIT_MODE_ADAPTIVE,     // spin, yield, then sleep with growing intervals
+    WAIT_MODE_DOORBELL      // sleep on the producer's doorbell, adaptive if it never rings
+};
+
+int                       mWaitMode     = WAIT_MODE_POLL;       // how to wait for the next frame
+Framework::ShmDoorbell    mDoorbell;                            // doorbell next to the SHM segment
+uint32_t                  mDoorbellSeq  = 0;                    // last doorbell sequence number seen
+uint64_t                  mDoorbellTime = 0;                    // time the doorbell was last seen rung, 0 = not waited for   @unit ns
+Framework::AdaptiveWaiter mWaiter;                              // spin-then-sleep waiting strategy
+Framework::TimingStats    mWakeStats;                           // wake-up latency of frames
+volatile sig_atomic_t     mQuit         = 0;                    // set by the signal handler
+
+unsigned int              mNoEncoderThreads = 2;                // number of threads writing images, per camera
+int                       mNoSharedEncoders = -1;               // number of threads writing the images of all cameras, 0 = threads per camera, -1 = default
+Framework::EncoderWorkers mEncoders;                            // threads writing the images of all cameras of all segments
+Framework::MemoryBudget   mBudget;                              // memory cap shared by the cameras of all segments
+unsigned int              mQueueDepth   = 4;                    // number of images which may wait for an encoder, per camera
+int                       mBackpressure = Framework::BACKPRESSURE_DROP_NEWEST;  // what happens to images when the encoders fall behind
+unsigned int              mMemoryCap    = 0;                    // memory of the images waiting for or being encoded, all cameras, 0 = unlimited @unit MB
+std::string               mOutputDir    = ".";                  // root of the per-camera output directories
+std::vector<uint16_t>     mCameraIds;                           // cameras to be written, empty = all
+std::string               mRecordName;                          // base name of the recording, empty = write images
+bool                      mRecordFailed = false;                // recording has failed, the reader stops
+Framework::FrameRecorder  mRecorder;                            // raw recording of the SHM messages
+Framework::TimingStats    mHoldStats;                           // time an SHM buffer is locked by the reader
+int                       mOrientation  = Framework::IMAGE_ORIENT_FLIP_VERTICAL;  // orientation of the written images
+int                       mPointCloud   = Framework::POINT_CLOUD_OFF;             // export depth images as point clouds?
+Framework::LatencyStats   mLatency;                             // latency of the processing stages, all threads
+unsigned int              mLatencyInterval = 10;                // interval of printing the latencies, 0 = at exit only
+cpu_set_t                 mIngestCpus;                          // CPUs of the thread reading the SHM
+bool                      mHasIngestCpus  = false;
+cpu_set_t                 mEncoderCpus;                         // CPUs of the encoder threads
+bool                      mHasEncoderCpus = false;
+int                       mRealtimePrio = 0;                    // SCHED_FIFO priority of the thread reading the SHM, 0 = normal scheduling
+bool                      mLockShm      = false;                // lock the segment into RAM and fault it in when attaching?
+uint64_t                  mBufferReady  = 0;                    // time the producer handed over the buffer being read
+uint64_t                  mBufferDetect = 0;                    // time the buffer being read was found
+uint64_t                  mBufferLock   = 0;                    // time the buffer being read was locked
+std::string               mFanOutName;                          // name of the ring publishing the frames to local consumers, empty = none
+unsigned int              mFanOutSlots  = 4;                    // number of slots of the ring
+unsigned int              mFanOutSlotSize = 32;                 // room for a frame in a slot @unit MB
+Framework::FrameRing      mFanOut;                              // ring publishing the frames to local consumers
+
 /**
 * information about usage of the software
 * this method will exit the program
 */
 void usage()
 {
-    printf("usage: shmReader [-k:key] [-c:checkMask] [-v] [-f:bufferId]\n\n");
-    printf("       -k:key        SHM key that is to be addressed\n");
+    printf("usage: shmReader [-k:keys] [-c:checkMask] [-v] [-f:bufferId] [-w:waitMode] [-e:threads] [-j:threads] [-q:depth] [-o:orientation] [-p:pointCloud] [-i:cameraIds] [-d:outputDir] [-r:recording] [-l:interval] [-b:backpressure] [-m:memoryCap] [-a:cpus] [-x:cpus] [-s:priority] [-t] [-y:threshold] [-n:ring]\n\n");
+    printf("       -k:keys       comma separated SHM keys that are to be addressed, e.g. 0x8130,0x8131; the images of each\n");
+    printf("                     segment go to <outputDir>/shm_<key> if there are several (default 0x8130)\n");
     printf("       -c:checkMask  mask against which to check before reading an SHM buffer\n");
-    printf("       -f:bufferId   force reading of a given buffer (0 or 1) instead of checking for a valid checkMask\n");
-    printf("       -v            run in verbose mode\n");
+    printf("       -f:bufferId   force reading of a given buffer (0..noBuffers-1) instead of picking the latest ready one\n");
+    printf("       -w:waitMode   how to wait for frames: poll (1 ms interval, default), adaptive (spin, then sleep)\n");
+    printf("                     or doorbell (wake-up by the producer, adaptive until it rings; adaptive for several keys)\n");
+    printf("       -e:threads    number of encoder threads per camera (default 2); with shared encoder threads, number\n");
+    printf("                     of images of a camera which may be encoded at the same time\n");
+    printf("       -j:threads    number of encoder threads shared by all cameras of all segments, 0 = threads per camera\n");
+    printf("                     (default: 0 for a single key, one per encoder CPU for several keys)\n");
+    printf("       -q:depth      number of images which may wait for an encoder, per camera (default 4)\n");
+    printf("       -o:orientation orientation of the written images: flip (vertical flip, default), rot180, hflip or none\n");
+    printf("       -p:pointCloud write depth images as point clouds: pcd (binary PCD), soa (raw x, y, z float planes) or off (default)\n");
+    printf("       -i:cameraIds  comma separated ids of the cameras to be written (default: all)\n");
+    printf("       -d:outputDir  directory receiving one camera_<id> directory per camera (default .)\n");
+    printf("       -r:recording  record the raw messages to recording_<n>.rdbrec + recording.rdbidx instead of writing images\n");
+    printf("                     (single key only)\n");
+    printf("       -l:interval   print the latencies of the processing stages every <interval> s, 0 = at exit only (default 10)\n");
+    printf("       -b:backpressure what to do when the encoders fall behind: drop (drop the new image, default), block (lossless,\n");
+    printf("                     holds the SHM buffer), oldest (replace the oldest waiting image), latest (keep only the latest image\n");
+    printf("                     per camera) or spill (write raw images to <outputDir>/camera_<id>/spill, encode them when idle)\n");
+    printf("       -m:memoryCap  upper limit of the memory of images waiting for or being encoded, all cameras, in MB (default: unlimited)\n");
+    printf("       -a:cpus       pin the thread reading the SHM to a list of CPUs, e.g. 2 or 2,4-5\n");
+    printf("       -x:cpus       pin the encoder threads to a list of CPUs (default: the CPUs the reader was started with)\n");
+    printf("       -s:priority   schedule the thread reading the SHM with SCHED_FIFO at the given priority (1..99)\n");
+    printf("       -t            lock the SHM segment into RAM and fault it in when attaching\n");
+    printf("       -y:threshold  copy images of at least <threshold> KB out of the SHM with non-temporal stores, 0 = never\n");
+    printf("                     (default: share of a core in the last level cache)\n");
+    printf("       -n:ring       publish the converted frames to local consumers in the POSIX shared memory ring\n");
+    printf("                     <name>[,<slots>[,<MB per slot>]] (default 4 slots of 32 MB), e.g. /image_frames\n");
+    printf("       -v            run in verbose mode (per-frame debug messages are only compiled in without NDEBUG)\n");
     exit(1);
 }
 
@@ -97,12 +289,24 @@ void ValidateArgs(int argc, char **argv)
             fprintf( stderr, "Reading parameters...\n" );
             switch (tolower(argv[i][1]))
             {
-                case 'k':        // shared memory key
+                case 'k':        // shared memory keys
                     if ( strlen( argv[i] ) > 3 )
                     {
+                        char* keys = &argv[i][3];
+                        
                         fprintf( stderr, "Reading key parameter...\n" );
-                        mShmKey = atoi( &argv[i][3] );
-                        fprintf( stderr, "found: %i\n", mShmKey );
+                        mShmKeys.clear();
+                        
+                        while ( *keys )
+                        {
+                            mShmKeys.push_back( Framework::parseShmKey( keys, &keys ) );
+                            fprintf( stderr, "found: 0x%x\n", mShmKeys.back() );
+                            
+                            if ( *keys == ',' )
+                                keys++;
+                            else if ( *keys )
+                                usage();
+                        }
                     }
                     break;
                     
@@ -116,6 +320,174 @@ void ValidateArgs(int argc, char **argv)
                         mForceBuffer = atoi( &argv[i][3] );
                     break;
                     
+                case 'w':       // wait mode
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        if ( !strcmp( &argv[i][3], "poll" ) )
+                            mWaitMode = WAIT_MODE_POLL;
+                        else if ( !strcmp( &argv[i][3], "adaptive" ) )
+                            mWaitMode = WAIT_MODE_ADAPTIVE;
+                        else if ( !strcmp( &argv[i][3], "doorbell" ) )
+                            mWaitMode = WAIT_MODE_DOORBELL;
+                        else
+                            usage();
+                    }
+                    break;
+                    
+                case 'e':       // number of encoder threads
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoEncoderThreads = atoi( &argv[i][3] );
+                    if ( !mNoEncoderThreads )
+                        usage();
+                    break;
+                    
+                case 'j':       // number of shared encoder threads
+                    if ( strlen( argv[i] ) > 3 )
+                        mNoSharedEncoders = atoi( &argv[i][3] );
+                    if ( mNoSharedEncoders < 0 )
+                        usage();
+                    break;
+                    
+                case 'q':       // depth of the encoder queue
+                    if ( strlen( argv[i] ) > 3 )
+                        mQueueDepth = atoi( &argv[i][3] );
+                    break;
+                    
+                case 'o':       // orientation of the written images
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        if ( !strcmp( &argv[i][3], "flip" ) )
+                            mOrientation = Framework::IMAGE_ORIENT_FLIP_VERTICAL;
+                        else if ( !strcmp( &argv[i][3], "rot180" ) )
+                            mOrientation = Framework::IMAGE_ORIENT_ROTATE_180;
+                        else if ( !strcmp( &argv[i][3], "hflip" ) )
+                            mOrientation = Framework::IMAGE_ORIENT_FLIP_HORIZONTAL;
+                        else if ( !strcmp( &argv[i][3], "none" ) )
+                            mOrientation = Framework::IMAGE_ORIENT_NONE;
+                        else
+                            usage();
+                    }
+                    break;
+                    
+                case 'p':       // point cloud export
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        if ( !strcmp( &argv[i][3], "pcd" ) )
+                            mPointCloud = Framework::POINT_CLOUD_PCD;
+                        else if ( !strcmp( &argv[i][3], "soa" ) )
+                            mPointCloud = Framework::POINT_CLOUD_SOA;
+                        else if ( !strcmp( &argv[i][3], "off" ) )
+                            mPointCloud = Framework::POINT_CLOUD_OFF;
+                        else
+                            usage();
+                    }
+                    break;
+                    
+                case 'i':       // cameras to be written
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        char* ids = &argv[i][3];
+                        
+                        while ( *ids )
+                        {
+                            mCameraIds.push_back( strtoul( ids, &ids, 0 ) );
+                            
+                            if ( *ids == ',' )
+                                ids++;
+                            else if ( *ids )
+                                usage();
+                        }
+                    }
+                    break;
+                    
+                case 'd':       // output directory
+                    if ( strlen( argv[i] ) > 3 )
+                        mOutputDir = &argv[i][3];
+                    break;
+                    
+                case 'r':       // record raw messages
+                    if ( strlen( argv[i] ) > 3 )
+                        mRecordName = &argv[i][3];
+                    break;
+                    
+                case 'l':       // latency report interval
+                    if ( strlen( argv[i] ) > 3 )
+                        mLatencyInterval = atoi( &argv[i][3] );
+                    break;
+                    
+                case 'b':       // backpressure policy
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        if ( !strcmp( &argv[i][3], "drop" ) )
+                            mBackpressure = Framework::BACKPRESSURE_DROP_NEWEST;
+                        else if ( !strcmp( &argv[i][3], "block" ) )
+                            mBackpressure = Framework::BACKPRESSURE_BLOCK;
+                        else if ( !strcmp( &argv[i][3], "oldest" ) )
+                            mBackpressure = Framework::BACKPRESSURE_DROP_OLDEST;
+                        else if ( !strcmp( &argv[i][3], "latest" ) )
+                            mBackpressure = Framework::BACKPRESSURE_KEEP_LATEST;
+                        else if ( !strcmp( &argv[i][3], "spill" ) )
+                            mBackpressure = Framework::BACKPRESSURE_SPILL;
+                        else
+                            usage();
+                    }
+                    break;
+                    
+                case 'm':       // memory cap
+                    if ( strlen( argv[i] ) > 3 )
+                        mMemoryCap = atoi( &argv[i][3] );
+                    break;
+                    
+                case 'a':       // CPUs of the ingest thread
+                    if ( ( strlen( argv[i] ) <= 3 ) || !Framework::parseCpuList( &argv[i][3], mIngestCpus ) )
+                        usage();
+                    mHasIngestCpus = true;
+                    break;
+                    
+                case 'x':       // CPUs of the encoders
+                    if ( ( strlen( argv[i] ) <= 3 ) || !Framework::parseCpuList( &argv[i][3], mEncoderCpus ) )
+                        usage();
+                    mHasEncoderCpus = true;
+                    break;
+                    
+                case 's':       // real-time priority of the ingest thread
+                    if ( strlen( argv[i] ) > 3 )
+                        mRealtimePrio = atoi( &argv[i][3] );
+                    if ( ( mRealtimePrio < 1 ) || ( mRealtimePrio > 99 ) )
+                        usage();
+                    break;
+                    
+                case 't':       // lock the segment
+                    mLockShm = true;
+                    break;
+                    
+                case 'y':       // threshold of the non-temporal copy
+                    if ( strlen( argv[i] ) > 3 )
+                        Framework::setStreamCopyThreshold( ( size_t ) atoi( &argv[i][3] ) << 10 );
+                    break;
+                    
+                case 'n':       // ring of frames for local consumers
+                    if ( strlen( argv[i] ) > 3 )
+                    {
+                        char* opt   = &argv[i][3];
+                        char* comma = strchr( opt, ',' );
+                        
+                        mFanOutName = std::string( opt, comma ? comma - opt : strlen( opt ) );
+                        
+                        if ( mFanOutName[ 0 ] != '/' )
+                            mFanOutName = "/" + mFanOutName;
+                        
+                        if ( comma )
+                            mFanOutSlots = strtoul( comma + 1, &comma, 0 );
+                        
+                        if ( comma && ( *comma == ',' ) )
+                            mFanOutSlotSize = strtoul( comma + 1, &comma, 0 );
+                        
+                        if ( ( comma && *comma ) || !mFanOutSlots || !mFanOutSlotSize )
+                            usage();
+                    }
+                    break;
+                    
                 case 'v':       // verbose mode
                     mVerbose = true;
                     break;
@@ -127,8 +499,20 @@ void ValidateArgs(int argc, char **argv)
         }
     }
     
-    fprintf( stderr, "ValidateArgs: key = 0x%x, checkMask = 0x%x, mForceBuffer = %d\n", 
-                     mShmKey, mCheckMask, mForceBuffer );
+    // the recording holds the messages of a single producer
+    if ( mShmKeys.empty() || ( ( mShmKeys.size() > 1 ) && !mRecordName.empty() ) )
+        usage();
+    
+    fprintf( stderr, "ValidateArgs: key = 0x%x (%lu keys), checkMask = 0x%x, mForceBuffer = %d, waitMode = %d, orientation = %d\n", 
+                     mShmKeys[ 0 ], ( unsigned long ) mShmKeys.size(), mCheckMask, mForceBuffer, mWaitMode, mOrientation );
+}
+
+/**
+* stop reading on SIGINT / SIGTERM so that statistics can be printed
+*/
+void sigHandler( int )
+{
+    mQuit = 1;
 }
 
 /**
@@ -142,195 +526,521 @@ int main(int argc, char* argv[])
     //
     ValidateArgs(argc, argv);
     
-    // first: open the shared memory (try to attach without creating a new segment)
+    // messages of the frame path are written by a thread of their own
+    if ( mVerbose )
+        Framework::AsyncLog::setLevel( Framework::LOG_LEVEL_DEBUG );
+    
+    Framework::AsyncLog::instance().start();
+    
+    // threads inherit the affinity of their creator, so the CPUs the encoders fall back to
+    // are taken before this thread is pinned; the logger has been started before for the same reason
+    if ( mHasIngestCpus && !mHasEncoderCpus )
+        mHasEncoderCpus = !sched_getaffinity( 0, sizeof( cpu_set_t ), &mEncoderCpus );
+    
+    // several segments share the encoder threads, so that a busy camera group may use the CPUs of an idle one
+    if ( mNoSharedEncoders < 0 )
+    {
+        cpu_set_t cpus;
+        
+        if ( mHasEncoderCpus )
+            cpus = mEncoderCpus;
+        else if ( sched_getaffinity( 0, sizeof( cpu_set_t ), &cpus ) )
+            CPU_ZERO( &cpus );
+        
+        mNoSharedEncoders = ( mShmKeys.size() > 1 ) ? std::max( CPU_COUNT( &cpus ), 1 ) : 0;
+    }
+    
+    if ( mNoSharedEncoders )
+    {
+        mEncoders.setAffinity( mHasEncoderCpus ? &mEncoderCpus : 0 );
+        mEncoders.start( mNoSharedEncoders );
+    }
+    
+    // the memory cap applies to all segments, whether or not they share the encoder threads
+    mBudget.setLimit( ( size_t ) mMemoryCap << 20 );
+    
+    if ( ( mShmKeys.size() > 1 ) && mkdir( mOutputDir.c_str(), 0755 ) && ( errno != EEXIST ) )
+        fprintf( stderr, "cannot create directory %s\n", mOutputDir.c_str() );
+    
+    for ( size_t i = 0; i < mShmKeys.size(); i++ )
+    {
+        ShmSource* source = new ShmSource( mShmKeys[ i ] );
+        std::string outputDir = mOutputDir;
+        
+        source->label = "ImageReader";
+        
+        if ( mShmKeys.size() > 1 )
+        {
+            char name[ 32 ];
+            
+            snprintf( name, sizeof( name ), " 0x%x", source->key );
+            source->label += name;
+            
+            snprintf( name, sizeof( name ), "/shm_0x%x", source->key );
+            outputDir += name;
+        }
+        
+        // the lanes of the cameras are created when their first image arrives
+        source->lanes.configure( encodeImageFrame, mNoEncoderThreads, mQueueDepth, outputDir );
+        source->lanes.setBackpressure( mBackpressure, ( size_t ) mMemoryCap << 20 );
+        source->lanes.setBudget( &mBudget );
+        
+        if ( mHasEncoderCpus )
+            source->lanes.setAffinity( mEncoderCpus );
+        
+        if ( mNoSharedEncoders )
+        {
+            source->lanes.setWorkers( &mEncoders );
+        }
+        
+        for ( size_t j = 0; j < mCameraIds.size(); j++ )
+            source->lanes.addCamera( mCameraIds[ j ] );
+        
+        mSources.push_back( source );
+    }
+    
+    if ( mHasIngestCpus )
+        Framework::setThreadAffinity( pthread_self(), mIngestCpus );
+    
+    if ( mRealtimePrio )
+        Framework::setThreadRealtime( pthread_self(), mRealtimePrio );
+    
+    signal( SIGINT,  sigHandler );
+    signal( SIGTERM, sigHandler );
+    
+    // first: open the shared memory (try to attach without creating a new segment); reading starts
+    // as soon as one segment is there, the others are attached by the scheduler once they show up
     
     fprintf( stderr, "attaching to shared memory....\n" );
     
-    while ( !mShmPtr )
+    for ( bool attached = false; !attached && !mQuit; )
     {
-        openShm();
+        for ( size_t i = 0; i < mSources.size(); i++ )
+        {
+            openShm( *mSources[ i ] );
+            attached |= mSources[ i ]->shm.isAttached();
+        }
+        
         usleep( 100000 );     // do not overload the CPU
     }
     
-    fprintf( stderr, "...attached! Reading now...\n" );
+    // a thread can only sleep on a single doorbell
+    if ( ( mWaitMode == WAIT_MODE_DOORBELL ) && ( mSources.size() > 1 ) )
+    {
+        fprintf( stderr, "doorbells are not used for several keys, waiting adaptively instead\n" );
+        mWaitMode = WAIT_MODE_ADAPTIVE;
+    }
+    
+    if ( mWaitMode == WAIT_MODE_DOORBELL )
+    {
+        if ( mDoorbell.open( mSources[ 0 ]->key ) )
+            fprintf( stderr, "doorbell %s opened\n", Framework::ShmDoorbell::name( mSources[ 0 ]->key ).c_str() );
+        else
+            mWaitMode = WAIT_MODE_ADAPTIVE;
+    }
+    
+    if ( !mRecordName.empty() && !mRecorder.open( mRecordName ) )
+    {
+        fprintf( stderr, "failed to open recording %s\n", mRecordName.c_str() );
+        return 1;
+    }
+    
+    if ( !mFanOutName.empty() )
+    {
+        if ( !mFanOut.create( mFanOutName, mFanOutSlots, ( size_t ) mFanOutSlotSize << 20 ) )
+        {
+            fprintf( stderr, "failed to create the frame ring %s\n", mFanOutName.c_str() );
+            return 1;
+        }
+        
+        fprintf( stderr, "publishing frames to %s, %u slots of %u MB\n", mFanOutName.c_str(), mFanOutSlots, mFanOutSlotSize );
+    }
+    
+    fprintf( stderr, "...attached! Reading now (pixel conversion: %s, non-temporal copy: %s from %lu KB, %s)...\n", Framework::pixelConvertIsa(),
+                     Framework::streamCopyIsa(), ( unsigned long ) ( Framework::getStreamCopyThreshold() >> 10 ),
+                     mNoSharedEncoders ? "shared encoder threads" : "encoder threads per camera" );
+    
+    uint64_t     tLastCheck   = Framework::monotonicNs();
+    uint64_t     tLastLatency = tLastCheck;
+    unsigned int first        = 0;
+    
+    for ( size_t i = 0; i < mSources.size(); i++ )
+        mSources[ i ]->tLastGeneration = tLastCheck;
     
     // now check the SHM for the time being
-    while ( 1 )
+    while ( !mQuit )
     {
-        checkShm();
+        bool     rung  = waitForShm();
+        uint64_t tWake = Framework::monotonicNs();
+        
+        // the buffer was handed over at the producer's ring, otherwise after the last check which found nothing
+        uint64_t tRef = tLastCheck;
+        
+        if ( rung )
+            tRef = mDoorbell.lastRingTime();
+        else if ( mWaitMode != WAIT_MODE_POLL )
+            tRef = mWaiter.lastMissTime();
+        
+        mBufferReady  = ( tRef && ( tWake >= tRef ) ) ? tRef : 0;
+        mBufferDetect = tWake;
+        
+        // the segments take turns in being served first, so that none of them is preferred
+        for ( size_t i = 0; i < mSources.size(); i++ )
+            serveShm( *mSources[ ( first + i ) % mSources.size() ], tWake );
         
-        usleep( 1000 );
+        first++;
+        
+        tLastCheck = tWake;
+        
+        if ( mLatencyInterval && ( tWake - tLastLatency >= mLatencyInterval * 1000000000ull ) )
+        {
+            mLatency.print( "ImageReader", true );
+            tLastLatency = tWake;
+        }
     }
+    
+    // write the images which are still queued
+    for ( size_t i = 0; i < mSources.size(); i++ )
+        mSources[ i ]->lanes.stop();
+    
+    // the shared encoder threads are stopped here, before the sources and their lanes are deleted
+    mEncoders.stop();
+    
+    Framework::AsyncLog::instance().stop();
+    
+    mWakeStats.print( "ImageReader: wake latency" );
+    mHoldStats.print( "ImageReader: SHM hold time" );
+    
+    for ( size_t i = 0; i < mSources.size(); i++ )
+        mSources[ i ]->lanes.printStats( mSources[ i ]->label.c_str() );
+    
+    if ( mNoSharedEncoders )
+        mEncoders.printStats( "ImageReader" );
+    
+    mLatency.print( "ImageReader" );
+    
+    if ( !mRecordName.empty() )
+    {
+        mRecorder.printStats( "ImageReader" );
+        mRecorder.close();
+    }
+    
+    if ( mFanOut.isOpen() )
+    {
+        fprintf( stderr, "ImageReader: %lu frames published to %s, %u too large for a slot\n", 
+                         ( unsigned long ) mFanOut.getNoPublished(), mFanOutName.c_str(), mFanOut.getNoTooLarge() );
+        mFanOut.close();
+    }
+    
+    for ( size_t i = 0; i < mSources.size(); i++ )
+    {
+        fprintf( stderr, "%s: %u buffers read, %u stale buffers skipped\n", mSources[ i ]->label.c_str(), mSources[ i ]->noFramesRead, mSources[ i ]->noBuffersSkipped );
+        delete mSources[ i ];
+    }
+    
+    return mRecordFailed ? 1 : 0;
 }
 
-/**
-* open the shared memory segment
-*/
-void openShm()
+void serveShm( ShmSource & source, uint64_t tWake )
 {
-    // do not open twice!
-    if ( mShmPtr )
+    // a missing segment is attached again as soon as the producer has created it
+    if ( !source.shm.isAttached() )
     {
-        fprintf( stderr, "openShm was already called\n" );
-        return;
+        if ( tWake < source.tNextAttach )
+            return;
+        
+        openShm( source );
+        
+        if ( !source.shm.isAttached() )
+        {
+            source.tNextAttach = tWake + SHM_ATTACH_RETRY_NS;
+            return;
+        }
+        
+        source.tLastGeneration = tWake;
+        
+        if ( !source.tDetached )
+            return;
+        
+        // the doorbell may have been created anew as well
+        if ( mWaitMode == WAIT_MODE_DOORBELL )
+        {
+            mDoorbell.open( source.key );
+            mDoorbellSeq = 0;
+        }
+        
+        // the frame numbers of the new producer start over
+        source.lastFrameNo = 0;
+        
+        fprintf( stderr, "%s: reattached after %.1f ms\n", source.label.c_str(), ( Framework::monotonicNs() - source.tDetached ) * 1.0e-6 );
+        
+        source.tDetached = 0;
     }
-
-    int shmid = 0; 
-
-    if ( ( shmid = shmget( mShmKey, 0, 0 ) ) < 0 )
+    
+    unsigned int noFramesRead = source.noFramesRead;
+    
+    checkShm( source );
+    
+    // wake latency: from the producer's ring, otherwise from the last check which found nothing
+    if ( source.noFramesRead != noFramesRead )
     {
-        fprintf( stderr, "No matching key %i != %ui \n", shmid, mShmKey);
-        return;
+        if ( mBufferReady )
+            mWakeStats.add( tWake - mBufferReady );
+        
+        if ( mVerbose && !( source.noFramesRead % 100 ) )
+        {
+            mWakeStats.print( "ImageReader: wake latency" );
+            mHoldStats.print( "ImageReader: SHM hold time" );
+            source.lanes.printStats( source.label.c_str() );
+        }
     }
-    else
+    
+    // a segment which stays silent may have been left behind by a restarted producer
+    if ( source.noFramesRead != noFramesRead )
+        source.tLastGeneration = tWake;
+    else if ( tWake - source.tLastGeneration >= SHM_GENERATION_CHECK_NS )
     {
-        fprintf( stderr, "Matching key %i\n", shmid);
+        source.tLastGeneration = tWake;
+        
+        if ( !source.shm.isCurrent() )
+            reattachShm( source, tWake );
     }
+}
 
-    if ( ( mShmPtr = (char *)shmat( shmid, (char *)0, 0 ) ) == (char *) -1 )
+bool waitForShm()
+{
+    switch ( mWaitMode )
     {
-        perror("openShm: shmat()");
-        mShmPtr = 0;
+        case WAIT_MODE_DOORBELL:
+            // the doorbell is only waited for while the producer rings it
+            if ( mDoorbell.hasRung() && mDoorbellTime && ( Framework::monotonicNs() - mDoorbellTime < DOORBELL_SILENCE_NS ) )
+            {
+                if ( mDoorbell.wait( mDoorbellSeq, 100000 ) )
+                {
+                    mDoorbellTime = Framework::monotonicNs();
+                    return true;
+                }
+                
+                // data without a ring: the producer does not use the doorbell (any more), e.g. restarted without it
+                if ( shmHasData( 0 ) )
+                    mDoorbellTime = 0;
+                
+                return false;
+            }
+            
+            // producers which never rang the doorbell, or stopped ringing it, are served by the adaptive strategy
+            mWaiter.wait( shmHasData, 0, 100000 );
+            
+            if ( mDoorbell.getSeq() != mDoorbellSeq )
+            {
+                mDoorbellSeq  = mDoorbell.getSeq();
+                mDoorbellTime = Framework::monotonicNs();
+            }
+            
+            return false;
+            
+        case WAIT_MODE_ADAPTIVE:
+            mWaiter.wait( shmHasData, 0, 100000 );
+            return false;
+            
+        default:
+            usleep( 1000 );
+            return false;
     }
+}
 
-    if ( mShmPtr )
+bool shmHasData( void* )
+{
+    if ( mQuit )
+        return true;
+    
+    for ( size_t n = 0; n < mSources.size(); n++ )
     {
-        struct shmid_ds sInfo;
-
-        if ( ( shmid = shmctl( shmid, IPC_STAT, &sInfo ) ) < 0 )
-            perror( "openShm: shmctl()" );
-        else
-            mShmTotalSize = sInfo.shm_segsz;
+        ShmSource& source = *mSources[ n ];
+        
+        if ( !source.shm.isAttached() )
+        {
+            if ( Framework::monotonicNs() >= source.tNextAttach )
+                return true;
+            
+            continue;
+        }
+        
+        if ( !source.shm.validate() )
+            continue;
+        
+        for ( unsigned int i = 0; i < source.shm.getNoBuffers(); i++ )
+        {
+            unsigned int flags = Framework::shmBufferGetFlags( source.shm.getBufferInfo( i ) );
+            
+            if ( ( ( flags & mCheckMask ) || !mCheckMask ) && !( flags & RDB_SHM_BUFFER_FLAG_LOCK ) )
+                return true;
+        }
     }
+    
+    return false;
 }
 
-int checkShm()
+/**
+* open the shared memory segment
+*/
+void openShm( ShmSource & source )
 {
-    if ( !mShmPtr )
-        return 0;
-
-    // get a pointer to the shm info block
-    RDB_SHM_HDR_t* shmHdr = ( RDB_SHM_HDR_t* ) ( mShmPtr );
+    // the buffer table is computed once here and only revalidated when the header changes
+    if ( !source.shm.attach( source.key ) )
+        return;
+    
+    if ( mVerbose )
+        fprintf( stderr, "openShm: attached %lu bytes of 0x%x, %u buffers\n", ( unsigned long ) source.shm.getTotalSize(), source.key, source.shm.getNoBuffers() );
+    
+    // the first frames shall not pay for page faults (and the pages shall not be swapped out)
+    if ( mLockShm && Framework::lockMemory( source.shm.getPtr(), source.shm.getTotalSize() ) && mVerbose )
+        fprintf( stderr, "openShm: locked %lu bytes\n", ( unsigned long ) source.shm.getTotalSize() );
+}
 
-    if ( !shmHdr )
-        return 0;
+void reattachShm( ShmSource & source, uint64_t tWake )
+{
+    fprintf( stderr, "%s: SHM segment 0x%x has been removed or replaced by the producer (%u processes attached), reattaching...\n",
+                     source.label.c_str(), source.key, source.shm.getNoAttached() );
+    
+    source.shm.detach();
+    
+    // the other segments are served while this one is missing
+    source.tDetached   = tWake;
+    source.tNextAttach = tWake;
+    
+    if ( mWaitMode == WAIT_MODE_DOORBELL )
+        mDoorbell.close();
+}
 
-    // Tianshu 2021.2.7 comment out
-    /*
-    if ( ( shmHdr->noBuffers != 2 ) )
-    {
-        fprintf( stderr, "checkShm: no or wrong number of buffers in shared memory. I need two buffers!" );
+int checkShm( ShmSource & source )
+{
+    // make sure the cached buffer table still matches the header
+    if ( !source.shm.validate() )
         return 0;
-    }
-    */
-    //fprintf( stderr, "no of buffer = %d\n", shmHdr->noBuffers);
 
-    // allocate space for the buffer infos
-    RDB_SHM_BUFFER_INFO_t** pBufferInfo = ( RDB_SHM_BUFFER_INFO_t** ) ( new char [ shmHdr->noBuffers * sizeof( RDB_SHM_BUFFER_INFO_t* ) ] );
-    RDB_SHM_BUFFER_INFO_t*  pCurrentBufferInfo = 0;
+    // the handlers of the packages work on the lanes and cameras of this segment
+    mSource = &source;
 
-    char* dataPtr = ( char* ) shmHdr;
-    dataPtr += shmHdr->headerSize;
+    unsigned int noBuffers = source.shm.getNoBuffers();
 
-    for ( int i = 0; i < shmHdr->noBuffers; i++ )
-    {
-        pBufferInfo[ i ] = ( RDB_SHM_BUFFER_INFO_t* ) dataPtr;
-        dataPtr += pBufferInfo[ i ]->thisSize;
-    }
+    RDB_SHM_BUFFER_INFO_t* pCurrentBufferInfo = 0;
 
-    // get the pointers to message section in each buffer
-    RDB_MSG_t* pRdbMsgA = ( RDB_MSG_t* ) ( ( ( char* ) mShmPtr ) + pBufferInfo[0]->offset );
-    //RDB_MSG_t* pRdbMsgB = ( RDB_MSG_t* ) ( ( ( char* ) mShmPtr ) + pBufferInfo[1]->offset );
-    
     // pointer to the message that will actually be read
     RDB_MSG_t* pRdbMsg  = 0;
-
-    // remember the flags that are set for each buffer
-    unsigned int flagsA = pBufferInfo[ 0 ]->flags;
-    //unsigned int flagsB = pBufferInfo[ 1 ]->flags;
-
-    // check whether any buffer is ready for reading (checkMask is set (or 0) and buffer is NOT locked)
-    bool readyForReadA = ( ( flagsA & mCheckMask ) || !mCheckMask ) && !( flagsA & RDB_SHM_BUFFER_FLAG_LOCK );
-    //bool readyForReadB = ( ( flagsB & mCheckMask ) || !mCheckMask ) && !( flagsB & RDB_SHM_BUFFER_FLAG_LOCK );
-
-    if ( mVerbose )
+    
+    int  selected    = -1;      // index of the buffer that will be read
+    unsigned int selectedFrameNo = 0;       // frame carried by the selected buffer
+    double       selectedSimTime = 0.0;     // simulation time of the selected buffer
+    bool notStarted  = true;    // all buffers still carry frame 0
+    bool lossless    = ( mBackpressure == Framework::BACKPRESSURE_BLOCK );   // read every buffer, oldest frame first
+    unsigned int readyMask[ 8 ] = { 0 };    // one bit per buffer (noBuffers is an 8 bit value)
+
+    FWLOG_DEBUG( "ImageReader::checkShm: before processing SHM\n" );
+
+    // check which buffers are ready for reading (checkMask is set (or 0) and buffer is NOT locked)
+    // and pick the one carrying the latest frame (the oldest one if lossless), unless a buffer is forced to be read
+    for ( unsigned int i = 0; i < noBuffers; i++ )
     {
-        fprintf( stderr, "ImageReader::checkShm: before processing SHM\n" );
-        fprintf( stderr, "ImageReader::checkShm: Buffer A: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>, readyForRead = <%s>\n", 
-                         pRdbMsgA->hdr.frameNo, 
-                         flagsA,
-                         ( flagsA & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
-                         ( flagsA & mCheckMask ) ? "true" : "false",
-                         readyForReadA ?  "true" : "false" );
-
-        /*
-        fprintf( stderr, "                       Buffer B: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>, readyForRead = <%s>\n", 
-                         pRdbMsgB->hdr.frameNo, 
-                         flagsB,
-                         ( flagsB & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
-                         ( flagsB & mCheckMask ) ? "true" : "false",
-                         readyForReadB ?  "true" : "false" );
-        */
+        RDB_SHM_BUFFER_INFO_t* info  = source.shm.getBufferInfo( i );
+        RDB_MSG_t*             pMsg  = source.shm.getMsg( i );
+        unsigned int           flags = Framework::shmBufferGetFlags( info );
+        uint32_t               generation;
+        
+        // the buffer is not locked yet, so the frame number is only valid if the producer has not written it meanwhile
+        bool         consistent = Framework::shmBufferBeginRead( info, generation );
+        unsigned int frameNo    = pMsg->hdr.frameNo;
+        double       simTime    = pMsg->hdr.simTime;
+        
+        consistent = consistent && Framework::shmBufferCheckRead( info, generation );
+        
+        bool readyForRead = ( ( flags & mCheckMask ) || !mCheckMask ) && !( flags & RDB_SHM_BUFFER_FLAG_LOCK ) && consistent;
+        
+        if ( frameNo )
+            notStarted = false;
+
+        FWLOG_DEBUG( "ImageReader::checkShm: Buffer %d: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>, readyForRead = <%s>\n", 
+                             i,
+                             frameNo, 
+                             flags,
+                             ( flags & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
+                             ( flags & mCheckMask ) ? "true" : "false",
+                             readyForRead ?  "true" : "false" );
+        
+        if ( !readyForRead )
+            continue;
+        
+        readyMask[ i / 32 ] |= 1u << ( i % 32 );
+        
+        if ( mForceBuffer >= 0 )                    // force reading a given buffer
+        {
+            if ( ( int ) i == mForceBuffer )
+                selected = i;
+        }
+        else if ( ( selected < 0 ) || ( lossless ? ( frameNo < selectedFrameNo ) : ( frameNo > selectedFrameNo ) ) )
+        {
+            selected        = i;                    // force using the latest image!!
+            selectedFrameNo = frameNo;
+            selectedSimTime = simTime;
+        }
     }
-
-    if (readyForReadA)
+    
+    if ( selected >= 0 )
     {
-        pRdbMsg = pRdbMsgA;
-        pCurrentBufferInfo = pBufferInfo[0];
+        pCurrentBufferInfo = source.shm.getBufferInfo( selected );
+        pRdbMsg            = source.shm.getMsg( selected );
     }
     
-    /*
-    if ( mForceBuffer < 0 )  // auto-select the buffer if none is forced to be read
+    // hand stale buffers back to the producer without reading them: older frames which
+    // are superseded by the selected one, and frames older than the last one read;
+    // when lossless, the other buffers are kept for the following polls instead
+    if ( ( mForceBuffer < 0 ) && mCheckMask && !lossless )
     {
-        // check which buffer to read
-        if ( ( readyForReadA ) && ( readyForReadB ) )
+        for ( unsigned int i = 0; i < noBuffers; i++ )
         {
-            if ( pRdbMsgA->hdr.frameNo > pRdbMsgB->hdr.frameNo )        // force using the latest image!!
-            {
-                pRdbMsg            = pRdbMsgA; 
-                pCurrentBufferInfo = pBufferInfo[ 0 ];
-            }
-            else
-            {
-                pRdbMsg            = pRdbMsgB; 
-                pCurrentBufferInfo = pBufferInfo[ 1 ];
-            }
-        }
-        else if ( readyForReadA )
-        {
-            pRdbMsg            = pRdbMsgA; 
-            pCurrentBufferInfo = pBufferInfo[ 0 ];
+            if ( ( ( int ) i == selected ) || !( readyMask[ i / 32 ] & ( 1u << ( i % 32 ) ) ) )
+                continue;
+            
+            // the producer may have locked the buffer for the next frame meanwhile, which is then left alone
+            if ( Framework::shmBufferChangeFlags( source.shm.getBufferInfo( i ), mCheckMask, RDB_SHM_BUFFER_FLAG_LOCK, 0, mCheckMask ) )
+                source.noBuffersSkipped++;
         }
-        else if ( readyForReadB )
+        
+        // a producer restarted within the same segment counts from the beginning, other older frames are stale
+        if ( pRdbMsg && source.noFramesRead && ( selectedFrameNo < source.lastFrameNo ) &&
+             !Framework::isSimRestart( selectedFrameNo, source.lastFrameNo, 1, selectedSimTime, source.lastSimTime, source.startSimTime ) )
         {
-            pRdbMsg            = pRdbMsgB;
-            pCurrentBufferInfo = pBufferInfo[ 1 ];
+            if ( Framework::shmBufferChangeFlags( pCurrentBufferInfo, mCheckMask, RDB_SHM_BUFFER_FLAG_LOCK, 0, mCheckMask ) )
+                source.noBuffersSkipped++;
+            
+            pRdbMsg            = 0;
+            pCurrentBufferInfo = 0;
         }
     }
-    else if ( ( mForceBuffer == 0 ) && readyForReadA )   // force reading buffer A
-    {
-        pRdbMsg            = pRdbMsgA; 
-        pCurrentBufferInfo = pBufferInfo[ 0 ];
-    }
-    else if ( ( mForceBuffer == 1 ) && readyForReadB ) // force reading buffer B
+    
+    // lock the buffer that will be processed now (by this, no other process will alter the contents); it is
+    // only locked if it is still ready, since the producer may have taken it back after it has been checked
+    if ( pCurrentBufferInfo && !Framework::shmBufferTryLock( pCurrentBufferInfo, mCheckMask ) )
     {
-        pRdbMsg            = pRdbMsgB;
-        pCurrentBufferInfo = pBufferInfo[ 1 ];
+        pRdbMsg            = 0;
+        pCurrentBufferInfo = 0;
     }
-    */
     
-    // lock the buffer that will be processed now (by this, no other process will alter the contents)
+    uint64_t tLock = Framework::monotonicNs();
+    
     if ( pCurrentBufferInfo )
-        pCurrentBufferInfo->flags |= RDB_SHM_BUFFER_FLAG_LOCK;
+    {
+        mBufferLock = tLock;
+        
+        mLatency.add( Framework::LATENCY_DETECT, mBufferReady, mBufferDetect );
+        mLatency.add( Framework::LATENCY_LOCK, mBufferDetect, tLock );
+    }
 
     // no data available?
     if ( !pRdbMsg || !pCurrentBufferInfo )
     {
-        delete pBufferInfo;
-        pBufferInfo = 0;
-
         // return with valid result if simulation is not yet running
-        if ( ( pRdbMsgA->hdr.frameNo == 0 ) ) //&& ( pRdbMsgB->hdr.frameNo == 0 ) )
+        if ( notStarted )
             return 1;
 
         // otherwise return a failure
@@ -340,17 +1050,46 @@ int checkShm()
     // handle all messages in the buffer
     if ( !pRdbMsg->hdr.dataSize )
     {
-        fprintf( stderr, "checkShm: zero message data size, error.\n" );
+        FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "checkShm: zero message data size, error.\n" );
+        
+        // the broken buffer goes back to the producer, it would otherwise be found again on every poll
+        Framework::shmBufferUnlock( pCurrentBufferInfo, mCheckMask );
         return 0;
     }
     
+    // the run is (re)started by the first frame read, after a reattach and by a frame number falling back
+    if ( !source.noFramesRead || !source.lastFrameNo || ( pRdbMsg->hdr.frameNo < source.lastFrameNo ) )
+        source.startSimTime = pRdbMsg->hdr.simTime;
+    
+    source.lastFrameNo = pRdbMsg->hdr.frameNo;
+    source.lastSimTime = pRdbMsg->hdr.simTime;
     
     unsigned int maxReadSize = pCurrentBufferInfo->bufferSize;
     
     while ( 1 )
     {
         // handle the message that is contained in the buffer; this method should be provided by the user (i.e. YOU!)
-        handleMessage( pRdbMsg );
+        // when recording, the raw message is appended to the recording instead (conversion is done offline)
+        if ( !mRecordName.empty() )
+        {
+            uint64_t tCopy = Framework::monotonicNs();
+            
+            // a recording which cannot be continued (e.g. disk full) stops the reader, it never falls back to writing images
+            if ( !mRecorder.record( pRdbMsg ) )
+            {
+                if ( !mRecordFailed )
+                    fprintf( stderr, "checkShm: recording %s failed, stopping\n", mRecordName.c_str() );
+                
+                mRecordFailed = true;
+                mQuit         = 1;
+                break;
+            }
+            
+            // when recording, "copy" is the append of the message to the recording
+            mLatency.add( Framework::LATENCY_COPY, tCopy, Framework::monotonicNs() );
+        }
+        else
+            handleMessage( pRdbMsg );
         
         // do not read more bytes than there are in the buffer (avoid reading a following buffer accidentally)
         maxReadSize -= pRdbMsg->hdr.dataSize + pRdbMsg->hdr.headerSize;
@@ -368,28 +1107,29 @@ int checkShm()
             break;
     }
     
-    // release after reading
-    pCurrentBufferInfo->flags &= ~mCheckMask;                   // remove the check mask
-    pCurrentBufferInfo->flags &= ~RDB_SHM_BUFFER_FLAG_LOCK;     // remove the lock mask
+    // release after reading, removing the check mask and the lock mask in one go
+    Framework::shmBufferUnlock( pCurrentBufferInfo, mCheckMask );
+    
+    mHoldStats.add( Framework::monotonicNs() - tLock );
+    
+    source.noFramesRead++;
 
     if ( mVerbose )
     {
-        unsigned int flagsA = pBufferInfo[ 0 ]->flags;
-        //unsigned int flagsB = pBufferInfo[ 1 ]->flags;
-
-        fprintf( stderr, "ImageReader::checkShm: after processing SHM\n" );
-        fprintf( stderr, "ImageReader::checkShm: Buffer A: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>\n", 
-                         pRdbMsgA->hdr.frameNo, 
-                         flagsA,
-                         ( flagsA & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
-                         ( flagsA & mCheckMask ) ? "true" : "false" );
-        /*
-        fprintf( stderr, "                       Buffer B: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>.\n", 
-                         pRdbMsgB->hdr.frameNo, 
-                         flagsB,
-                         ( flagsB & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
-                         ( flagsB & mCheckMask ) ? "true" : "false" );
-        */
+        FWLOG_DEBUG( "ImageReader::checkShm: after processing SHM, read buffer %d\n", selected );
+        
+        for ( unsigned int i = 0; i < noBuffers; i++ )
+        {
+            RDB_MSG_t*   pMsg  = source.shm.getMsg( i );
+            unsigned int flags = Framework::shmBufferGetFlags( source.shm.getBufferInfo( i ) );
+            
+            FWLOG_DEBUG( "ImageReader::checkShm: Buffer %d: frameNo = %06d, flags = 0x%x, locked = <%s>, lock mask set = <%s>\n", 
+                             i,
+                             pMsg->hdr.frameNo, 
+                             flags,
+                             ( flags & RDB_SHM_BUFFER_FLAG_LOCK ) ? "true" : "false",
+                             ( flags & mCheckMask ) ? "true" : "false" );
+        }
     }
 
     return 1;
@@ -435,13 +1175,16 @@ void parseRDBMessageEntry( const double & simTime, const unsigned int & simFrame
         switch (entryHdr->pkgId)
         {
             case RDB_PKG_ID_IMAGE:
-                fprintf(stderr, "Package type RDB_PKG_ID_IMAGE\n");
+                FWLOG_DEBUG( "Package type RDB_PKG_ID_IMAGE\n" );
                 handleRDBitem(simTime, simFrame, (RDB_IMAGE_t*) dataPtr, counter++);
                 break;
             case RDB_PKG_ID_CUSTOM_OPTIX_START:
-                fprintf(stderr, "Package type RDB_PKG_ID_CUSTOM_OPTIX_START\n");
+                FWLOG_DEBUG( "Package type RDB_PKG_ID_CUSTOM_OPTIX_START\n" );
                 handleRDBitem(simTime, simFrame, (RDB_IMAGE_t*) dataPtr, counter++);
                 break;
+            case RDB_PKG_ID_CAMERA:
+                handleRDBitem(simTime, simFrame, (RDB_CAMERA_t*) dataPtr);
+                break;
 
             default:
                 //fprintf( stderr, "Unsupported package type %u \n", entryHdr->pkgId);
@@ -454,35 +1197,87 @@ void parseRDBMessageEntry( const double & simTime, const unsigned int & simFrame
 
 void handleRDBitem( const double & simTime, const unsigned int & simFrame, RDB_IMAGE_t* msgImage, int counter)
 {
-    fprintf( stderr, "handleRDBitem: called" );
-    
     if ( !msgImage )
         return;
+    
+    // images of cameras without consumer are skipped before anything is copied
+    Framework::CameraLane* lane = mSource->lanes.getLane( msgImage->cameraId );
+    
+    if ( !lane )
+        return;
+    
+    // gaps in the sequence of the camera reveal frames overwritten before they could be read
+    lane->track( simFrame, msgImage->id, simTime );
+    
+    // images are numbered per camera within a simulation frame
+    counter = lane->nextCounter( simFrame );
 
-    fprintf( stderr, "handleRDBitem: image\n" );
-    fprintf( stderr, "    simTime = %.3lf, simFrame = %ld\n", simTime, simFrame);
-    fprintf( stderr, "    width / height = %d / %d\n", msgImage->width, msgImage->height );
-    fprintf( stderr, "    dataSize = %d\n", msgImage->imgSize );
-    fprintf( stderr, "    RDB_PIX_FORMAT = %hu\n", msgImage->pixelFormat );
+    FWLOG_DEBUG( "handleRDBitem: image, simTime = %.3lf, simFrame = %u, width / height = %d / %d, dataSize = %u, RDB_PIX_FORMAT = %hu\n",
+                 simTime, simFrame, msgImage->width, msgImage->height, msgImage->imgSize, msgImage->pixelFormat );
 
 
-    // Tianshu 2021.2.7 RGB8
-    if (msgImage->pixelFormat != RDB_PIX_FORMAT_RGB8) 
+    // the conversion is looked up by pixel format and pixel size (see PixelConvert.cc for the table)
+    const Framework::PIXEL_CONVERSION_t* conv = Framework::findPixelConversion( msgImage->pixelFormat, msgImage->pixelSize );
+    
+    if ( !conv )
     {
-        std::cerr << "dumpBufferStructAsFile: Only pixelformat RDB_PIX_FORMAT_RGBA32F supported for writing files. Aborting writing file. " << msgImage->pixelFormat << std::endl;
+        FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "handleRDBitem: pixel format %hu with %u bits per pixel is not supported. Aborting writing file.\n", 
+                    msgImage->pixelFormat, msgImage->pixelSize );
         return;
     }
 
-    // Tianshu 2021.2.7 
-    static const int NUMBER_OF_VALUES = 3;  //4;
-
-    int width = msgImage->width*NUMBER_OF_VALUES;
+    int width  = msgImage->width;
     int height = msgImage->height;
     
-    // PCD
-//    std::stringstream sstrFileNamePCD;
-//    sstrFileNamePCD << "/tmp/point_cloud_frame_" << simFrame << "_time_" << simTime << "_" << counter << ".pcd";
-//    std::ofstream filePCD(sstrFileNamePCD.str().c_str());
+    // depth images are back-projected right out of the SHM buffer, if the camera is known
+    if ( ( mPointCloud != Framework::POINT_CLOUD_OFF ) && Framework::DepthProjector::isDepthFormat( msgImage->pixelFormat, msgImage->pixelSize ) )
+    {
+        std::map<uint16_t, RDB_CAMERA_t>::iterator cam = mSource->cameras.find( msgImage->cameraId );
+        
+        Framework::DepthProjector& projector = mSource->projectors[ msgImage->cameraId ];
+        
+        if ( ( cam != mSource->cameras.end() ) && projector.setup( cam->second, *msgImage ) )
+        {
+            if ( msgImage->imgSize < ( size_t ) width * height * ( msgImage->pixelSize / 8 ) )
+            {
+                FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "handleRDBitem: depth image data size %u too small for %d x %d pixels\n", msgImage->imgSize, width, height );
+                return;
+            }
+            
+            bool soa = ( mPointCloud == Framework::POINT_CLOUD_SOA );
+            
+            // the points may be published to the local consumers even if the encoders have no room for them
+            Framework::ImageFrame*        frame = mSource->lanes.acquire( lane, projector.getOutputSize() );
+            Framework::FRAME_RING_SLOT_t* slot  = mFanOut.beginWrite( projector.getOutputSize() );
+            
+            if ( !frame && !slot )
+                return;
+            
+            uint64_t tCopy = Framework::monotonicNs();
+            
+            projector.project( msgImage + 1, ( float* ) ( frame ? frame->data : Framework::FrameRing::getData( slot ) ), soa );
+            
+            publishFrame( slot, frame ? frame->data : 0, simTime, simFrame, msgImage, 3, Framework::PIXEL_CHANNEL_F32, soa ? 2 : 1 );
+            
+            mLatency.add( Framework::LATENCY_COPY, mBufferLock, tCopy );
+            mLatency.add( Framework::LATENCY_CONVERT, tCopy, Framework::monotonicNs() );
+            
+            if ( !frame )
+                return;
+            
+            frame->simTime    = simTime;
+            frame->simFrame   = simFrame;
+            frame->counter    = counter;
+            frame->info       = *msgImage;
+            frame->pointCloud = true;
+            frame->tReady     = mBufferReady;
+            
+            mSource->lanes.submit( lane, frame );
+            return;
+        }
+        
+        FWLOG_RATE( Framework::LOG_LEVEL_WARN, 1000, "handleRDBitem: no usable camera package for camera %hu, writing depth image instead of point cloud\n", msgImage->cameraId );
+    }
     
     // Extra Data
 //    std::stringstream sstrFileNameData;
@@ -525,20 +1320,6 @@ void handleRDBitem( const double & simTime, const unsigned int & simFrame, RDB_I
     // fileIMG.write( data, msgImage->imgSize );
 
     
-    // filePCD << "# .PCD v.7 - Point Cloud Data file format" << "\n";
-    // filePCD <<  "VERSION .7"   << "\n";
-    // filePCD <<  "FIELDS x y z" << "\n";
-    // filePCD <<  "SIZE 4 4 4"   << "\n";
-    // filePCD <<  "TYPE F F F"   << "\n";
-    // filePCD <<  "COUNT 1 1 1"  << "\n";
-    // filePCD <<  "WIDTH "  << msgImage->width  << "\n";
-    // filePCD <<  "HEIGHT " << msgImage->height << "\n";
-    // filePCD <<  "VIEWPOINT 0 0 0 1 0 0 0"      << "\n";
-    // filePCD <<  "POINTS " << (msgImage->width * msgImage->height)  << "\n";
-    // filePCD <<  "DATA ascii" << "\n";
-    // filePCD <<  "" << "\n";
-   
-    
     // RED
     for (int y = 0; y < height ; y++)
     {
@@ -569,29 +1350,161 @@ void handleRDBitem( const double & simTime, const unsigned int & simFrame, RDB_I
     } */
  
 //OPENCV方式
-    char *data = (char*)(msgImage+1);
-    // fprintf( stderr, "ZOU: write rgb data ");
-    // fileIMG.write( data, msgImage->imgSize );
-    cv::Mat YUVImg(height, width/3, CV_8UC3,(unsigned char*)data);
-    if(YUVImg.data == nullptr){
-        std::cout << "[CallbackCameraImage_cdds]  receiver img null!"  << std::endl;
+    // convert the image out of the SHM buffer in a single pass (channel order, type and orientation);
+    // encoding is done by the encoder threads, so that the buffer can be handed back right away
+    size_t imgSize = ( size_t ) width * height * ( conv->pixelSize / 8 );
+    
+    if ( msgImage->imgSize < imgSize )
+    {
+        FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "handleRDBitem: image data size %u too small for %d x %d %s pixels\n", msgImage->imgSize, width, height, conv->name );
         return;
-        }
-    std::stringstream sstrFileNameIMG;
-    sstrFileNameIMG << "image_frame_" << simFrame << "_time_" << simTime << "_" << counter << ".png";
-    cv::Mat RGBImg(height,width/3, CV_8UC3);
-    cv::cvtColor(YUVImg, RGBImg, cv::COLOR_RGB2BGR);
-    cv::Mat RGBImg_rotate(height,width/3, CV_8UC3);
-    cv::Mat RGBImg_flip(height,width/3, CV_8UC3);
-    // cv::imwrite(sstrFileNameIMG.str().c_str(),  RGBImg);
-    // cv::rotate(RGBImg, RGBImg_rotate, cv::ROTATE_180);
-    // cv::imwrite(sstrFileNameIMG.str().c_str(),  RGBImg_rotate);
-    cv::flip(RGBImg, RGBImg_flip,0);
-    cv::imwrite(sstrFileNameIMG.str().c_str(),  RGBImg_flip);
-
+    }
+    
+    size_t dataSize = ( size_t ) width * height * Framework::convertedPixelSize( conv );
+    
+    // the image may be published to the local consumers even if the encoders have no room for it;
+    // it is converted into the slot right away then, otherwise copied from the frame
+    Framework::ImageFrame*        frame = mSource->lanes.acquire( lane, dataSize );
+    Framework::FRAME_RING_SLOT_t* slot  = mFanOut.beginWrite( dataSize );
+    
+    if ( !frame && !slot )
+        return;
+    
+    uint64_t tCopy = Framework::monotonicNs();
+    
+    Framework::convertImage( conv, msgImage + 1, frame ? frame->data : Framework::FrameRing::getData( slot ), width, height, mOrientation );
+    
+    publishFrame( slot, frame ? frame->data : 0, simTime, simFrame, msgImage, conv->channels, conv->channelType, 0 );
+    
+    mLatency.add( Framework::LATENCY_COPY, mBufferLock, tCopy );
+    mLatency.add( Framework::LATENCY_CONVERT, tCopy, Framework::monotonicNs() );
+    
+    if ( !frame )
+        return;
+    
+    frame->simTime    = simTime;
+    frame->simFrame   = simFrame;
+    frame->counter    = counter;
+    frame->info       = *msgImage;
+    frame->pointCloud = false;
+    frame->tReady     = mBufferReady;
+    
+    mSource->lanes.submit( lane, frame );
+}
 
+void publishFrame( Framework::FRAME_RING_SLOT_t* slot, const char* data, const double & simTime, const unsigned int & simFrame,
+                   const RDB_IMAGE_t* img, int channels, int channelType, int pointCloud )
+{
+    if ( !slot )
+        return;
+    
+    // the consumers are other processes, so the copy does not need to stay in the cache
+    if ( data )
+        Framework::streamCopy( Framework::FrameRing::getData( slot ), data, slot->dataSize );
+    
+    slot->simTime     = simTime;
+    slot->simFrame    = simFrame;
+    slot->shmKey      = mSource->key;
+    slot->width       = img->width;
+    slot->height      = img->height;
+    slot->channels    = channels;
+    slot->channelType = channelType;
+    slot->orientation = pointCloud ? Framework::IMAGE_ORIENT_NONE : mOrientation;
+    slot->pointCloud  = pointCloud;
+    slot->tReady      = mBufferReady;
+    slot->info        = *img;
     
+    mFanOut.endWrite( slot );
+}
 
+void encodeImageFrame( Framework::ImageFrame* frame )
+{
+    mLatency.add( Framework::LATENCY_QUEUE, frame->tSubmit, frame->tStart );
+    
+    uint64_t tWritten = 0;
     
+    if ( frame->pointCloud )
+    {
+        bool soa = ( mPointCloud == Framework::POINT_CLOUD_SOA );
+        
+        std::stringstream sstrFileNamePCD;
+        sstrFileNamePCD << frame->outputDir << "/point_cloud_frame_" << frame->simFrame << "_time_" << frame->simTime << "_" << frame->counter;
+        
+        if ( soa )
+            sstrFileNamePCD << "_" << frame->info.width << "x" << frame->info.height << ".f32";
+        else
+            sstrFileNamePCD << ".pcd";
+        
+        Framework::writePointCloud( sstrFileNamePCD.str().c_str(), ( const float* ) frame->data, frame->info.width, frame->info.height, soa );
+        
+        tWritten = Framework::monotonicNs();
+        
+        mLatency.add( Framework::LATENCY_WRITE, frame->tStart, tWritten );
+    }
+    else
+    {
+        // the data has already been converted and oriented by handleRDBitem()
+        const Framework::PIXEL_CONVERSION_t* conv = Framework::findPixelConversion( frame->info.pixelFormat, frame->info.pixelSize );
+        
+        static const int depth[] = { CV_8U, CV_16U, CV_32F };
+        
+        cv::Mat img( frame->info.height, frame->info.width, CV_MAKETYPE( depth[ conv->channelType ], conv->channels ), ( unsigned char* ) frame->data );
+        
+        // PNG holds 8 and 16 bit channels, floating point data (HDR colour, normalized depth) goes to TIFF
+        const char* ext = ( conv->channelType == Framework::PIXEL_CHANNEL_F32 ) ? ".tiff" : ".png";
+        
+        std::stringstream sstrFileNameIMG;
+        sstrFileNameIMG << frame->outputDir << "/image_frame_" << frame->simFrame << "_time_" << frame->simTime << "_" << frame->counter << ext;
+        
+        // encoding and writing are separated, so that their latencies can be told apart
+        static thread_local std::vector<uchar> encoded;
+        
+        if ( !cv::imencode( ext, img, encoded ) )
+        {
+            FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "encodeImageFrame: failed to encode %s\n", sstrFileNameIMG.str().c_str() );
+            return;
+        }
+        
+        uint64_t tEncoded = Framework::monotonicNs();
+        
+        mLatency.add( Framework::LATENCY_ENCODE, frame->tStart, tEncoded );
+        
+        FILE* fp = fopen( sstrFileNameIMG.str().c_str(), "wb" );
+        
+        if ( !fp )
+        {
+            FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "encodeImageFrame: fopen(): %s\n", strerror( errno ) );
+            return;
+        }
+        
+        bool ok = fwrite( &encoded[0], 1, encoded.size(), fp ) == encoded.size();
+        
+        if ( fclose( fp ) || !ok )
+        {
+            FWLOG_RATE( Framework::LOG_LEVEL_ERROR, 1000, "encodeImageFrame: failed to write %s\n", sstrFileNameIMG.str().c_str() );
+            return;
+        }
+        
+        tWritten = Framework::monotonicNs();
+        
+        mLatency.add( Framework::LATENCY_WRITE, tEncoded, tWritten );
+    }
+    
+    mLatency.add( Framework::LATENCY_TOTAL, frame->tReady, tWritten );
+    
+    if ( frame->tReady )
+        FWLOG_DEBUG( "encodeImageFrame: frame %u, camera %hu: %.1f us from handover to file\n",
+                     frame->simFrame, frame->info.cameraId, ( tWritten - frame->tReady ) * 1.0e-3 );
 }
 
+void handleRDBitem( const double & simTime, const unsigned int & simFrame, RDB_CAMERA_t* camera )
+{
+    if ( !camera )
+        return;
+    
+    FWLOG_DEBUG( "handleRDBitem: frame %u, time %.3f: camera %hu, %hu x %hu, focal = %.1f / %.1f, principal = %.1f / %.1f, clip = %.2f / %.2f\n",
+                 simFrame, simTime, camera->id, camera->width, camera->height, camera->focalX, camera->focalY, 
+                 camera->principalX, camera->principalY, camera->clipNear, camera->clipFar );
+    
+    mSource->cameras[ camera->id ] = *camera;
+}
@@ -0,0 +1,275 @@
+/* ===================================================
+ *  file:       ShmSegment.cc
+ * ---------------------------------------------------
+ *  purpose:	attachment to an RDB shared memory segment
+ *              with a cached buffer table
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <sys/shm.h>
+#include "ShmSegment.hh"
+#include "AsyncLog.hh"
+
+namespace Framework
+{
+
+ShmSegment::ShmSegment() : mShmPtr( 0 ),
+                           mShmTotalSize( 0 ),
+                           mShmKey( 0 ),
+                           mShmId( -1 ),
+                           mCtime( 0 ),
+                           mNoAttached( 0 ),
+                           mHdrSize( 0 ),
+                           mDataSize( 0 ),
+                           mNoBuffers( 0 ),
+                           mValid( false )
+{
+}
+
+ShmSegment::~ShmSegment()
+{
+    detach();
+}
+
+bool
+ShmSegment::attach( unsigned int shmKey )
+{
+    // do not open twice!
+    if ( mShmPtr )
+    {
+        fprintf( stderr, "ShmSegment::attach: already attached\n" );
+        return true;
+    }
+
+    int shmid = 0;
+
+    // attaching is retried until the producer has created the segment
+    if ( ( shmid = shmget( shmKey, 0, 0 ) ) < 0 )
+    {
+        FWLOG_RATE( LOG_LEVEL_INFO, 5000, "No matching key %i != %ui \n", shmid, shmKey );
+        return false;
+    }
+    else
+    {
+        FWLOG_INFO( "Matching key %i\n", shmid );
+    }
+
+    if ( ( mShmPtr = ( char * ) shmat( shmid, ( char * ) 0, 0 ) ) == ( char * ) -1 )
+    {
+        perror( "ShmSegment::attach: shmat()" );
+        mShmPtr = 0;
+        return false;
+    }
+
+    struct shmid_ds sInfo;
+
+    if ( shmctl( shmid, IPC_STAT, &sInfo ) < 0 )
+    {
+        perror( "ShmSegment::attach: shmctl()" );
+        detach();
+        return false;
+    }
+
+    mShmTotalSize = sInfo.shm_segsz;
+    mShmKey       = shmKey;
+    mShmId        = shmid;
+    mCtime        = sInfo.shm_ctime;
+    mNoAttached   = sInfo.shm_nattch;
+
+    // the producer may not have configured the segment yet; this is checked again on every validate()
+    rebuild();
+
+    return true;
+}
+
+void
+ShmSegment::detach()
+{
+    if ( mShmPtr )
+        shmdt( mShmPtr );
+
+    mShmPtr       = 0;
+    mShmTotalSize = 0;
+    mShmId        = -1;
+    mValid        = false;
+    mNoBuffers    = 0;
+
+    mBufferInfo.clear();
+    mMsg.clear();
+    mOffset.clear();
+    mThisSize.clear();
+}
+
+bool
+ShmSegment::isAttached() const
+{
+    return mShmPtr != 0;
+}
+
+bool
+ShmSegment::isCurrent()
+{
+    if ( !mShmPtr )
+        return false;
+
+    struct shmid_ds sInfo;
+
+    if ( shmctl( mShmId, IPC_STAT, &sInfo ) < 0 )
+        return false;
+
+    mNoAttached = sInfo.shm_nattch;
+
+    // removed by the producer and only kept alive by this attachment
+    if ( sInfo.shm_perm.mode & SHM_DEST )
+        return false;
+
+    if ( sInfo.shm_ctime != mCtime )
+        return false;
+
+    // a new producer may have created a segment of its own under the key
+    int shmid = shmget( mShmKey, 0, 0 );
+
+    if ( ( shmid >= 0 ) && ( shmid != mShmId ) )
+        return false;
+
+    // a header which does not fit into the segment is not going to become valid again
+    RDB_SHM_HDR_t* shmHdr = ( RDB_SHM_HDR_t* ) mShmPtr;
+
+    if ( shmHdr->headerSize && ( ( size_t ) shmHdr->headerSize + shmHdr->dataSize > mShmTotalSize ) )
+        return false;
+
+    return true;
+}
+
+unsigned int
+ShmSegment::getNoAttached() const
+{
+    return mNoAttached;
+}
+
+bool
+ShmSegment::isUnchanged() const
+{
+    RDB_SHM_HDR_t* shmHdr = ( RDB_SHM_HDR_t* ) mShmPtr;
+
+    if ( ( shmHdr->headerSize != mHdrSize ) || ( shmHdr->dataSize != mDataSize ) || ( shmHdr->noBuffers != mNoBuffers ) )
+        return false;
+
+    // buffers may be relocated by the producer without changing the header
+    for ( unsigned int i = 0; i < mNoBuffers; i++ )
+    {
+        if ( ( mBufferInfo[ i ]->thisSize != mThisSize[ i ] ) || ( mBufferInfo[ i ]->offset != mOffset[ i ] ) )
+            return false;
+    }
+
+    return true;
+}
+
+bool
+ShmSegment::validate()
+{
+    if ( !mShmPtr )
+        return false;
+
+    if ( mValid && isUnchanged() )
+        return true;
+
+    return rebuild();
+}
+
+bool
+ShmSegment::rebuild()
+{
+    RDB_SHM_HDR_t* shmHdr = ( RDB_SHM_HDR_t* ) mShmPtr;
+
+    mValid     = false;
+    mHdrSize   = shmHdr->headerSize;
+    mDataSize  = shmHdr->dataSize;
+    mNoBuffers = shmHdr->noBuffers;
+
+    mBufferInfo.resize( mNoBuffers );
+    mMsg.resize( mNoBuffers );
+    mOffset.resize( mNoBuffers );
+    mThisSize.resize( mNoBuffers );
+
+    if ( !mNoBuffers || !mHdrSize )
+        return false;
+
+    size_t infoPos = mHdrSize;
+
+    for ( unsigned int i = 0; i < mNoBuffers; i++ )
+    {
+        if ( infoPos + sizeof( RDB_SHM_BUFFER_INFO_t ) > mShmTotalSize )
+        {
+            FWLOG_RATE( LOG_LEVEL_WARN, 1000, "ShmSegment::rebuild: buffer info %u exceeds the segment\n", i );
+            return false;
+        }
+
+        RDB_SHM_BUFFER_INFO_t* info = ( RDB_SHM_BUFFER_INFO_t* ) ( ( ( char* ) mShmPtr ) + infoPos );
+
+        if ( !info->thisSize || ( ( size_t ) info->offset + info->bufferSize > mShmTotalSize ) )
+        {
+            FWLOG_RATE( LOG_LEVEL_WARN, 1000, "ShmSegment::rebuild: buffer %u is not configured or exceeds the segment\n", i );
+            return false;
+        }
+
+        mBufferInfo[ i ] = info;
+        mThisSize[ i ]   = info->thisSize;
+        mOffset[ i ]     = info->offset;
+        mMsg[ i ]        = ( RDB_MSG_t* ) ( ( ( char* ) mShmPtr ) + info->offset );
+
+        infoPos += info->thisSize;
+    }
+
+    mValid = true;
+
+    return true;
+}
+
+RDB_SHM_HDR_t*
+ShmSegment::getHdr() const
+{
+    return ( RDB_SHM_HDR_t* ) mShmPtr;
+}
+
+void*
+ShmSegment::getPtr() const
+{
+    return mShmPtr;
+}
+
+size_t
+ShmSegment::getTotalSize() const
+{
+    return mShmTotalSize;
+}
+
+unsigned int
+ShmSegment::getNoBuffers() const
+{
+    return mValid ? mNoBuffers : 0;
+}
+
+RDB_SHM_BUFFER_INFO_t*
+ShmSegment::getBufferInfo( unsigned int index ) const
+{
+    if ( !mValid || ( index >= mNoBuffers ) )
+        return 0;
+
+    return mBufferInfo[ index ];
+}
+
+RDB_MSG_t*
+ShmSegment::getMsg( unsigned int index ) const
+{
+    if ( !mValid || ( index >= mNoBuffers ) )
+        return 0;
+
+    return mMsg[ index ];
+}
+
+} // namespace Framework
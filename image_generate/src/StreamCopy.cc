@@ -0,0 +1,222 @@
+/* ===================================================
+ *  file:       StreamCopy.cc
+ * ---------------------------------------------------
+ *  purpose:	copy of large payloads with non-temporal
+ *              stores, so that they do not evict the
+ *              working sets of other threads from cache
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <atomic>
+#include "StreamCopy.hh"
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define STREAM_COPY_X86
+#include <immintrin.h>
+#endif
+
+/* ====== DEFINITIONS ====== */
+#define STREAM_COPY_PREFETCH        512             // distance of the software prefetch ahead of the loads @unit byte
+#define STREAM_COPY_DEFAULT_CACHE   ( 1 << 20 )     // cache size assumed if the system does not tell   @unit byte
+
+namespace Framework
+{
+
+typedef void ( *StreamCopyFunc )( uint8_t* dst, const uint8_t* src, size_t size );
+
+static void
+streamCopyPlain( uint8_t* dst, const uint8_t* src, size_t size )
+{
+    memcpy( dst, src, size );
+}
+
+#ifdef STREAM_COPY_X86
+
+__attribute__(( target( "sse2" ) )) static void
+streamCopySse2( uint8_t* dst, const uint8_t* src, size_t size )
+{
+    // the streaming stores need an aligned destination, the loads do not
+    size_t head = ( 16 - ( ( uintptr_t ) dst & 15 ) ) & 15;
+
+    if ( head > size )
+        head = size;
+
+    memcpy( dst, src, head );
+
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    for ( ; size >= 64; size -= 64, src += 64, dst += 64 )
+    {
+        _mm_prefetch( ( const char* ) src + STREAM_COPY_PREFETCH, _MM_HINT_T0 );
+
+        __m128i a = _mm_loadu_si128( ( const __m128i* ) src );
+        __m128i b = _mm_loadu_si128( ( const __m128i* ) ( src + 16 ) );
+        __m128i c = _mm_loadu_si128( ( const __m128i* ) ( src + 32 ) );
+        __m128i d = _mm_loadu_si128( ( const __m128i* ) ( src + 48 ) );
+
+        _mm_stream_si128( ( __m128i* ) dst, a );
+        _mm_stream_si128( ( __m128i* ) ( dst + 16 ), b );
+        _mm_stream_si128( ( __m128i* ) ( dst + 32 ), c );
+        _mm_stream_si128( ( __m128i* ) ( dst + 48 ), d );
+    }
+
+    memcpy( dst, src, size );
+}
+
+__attribute__(( target( "avx" ) )) static void
+streamCopyAvx( uint8_t* dst, const uint8_t* src, size_t size )
+{
+    size_t head = ( 32 - ( ( uintptr_t ) dst & 31 ) ) & 31;
+
+    if ( head > size )
+        head = size;
+
+    memcpy( dst, src, head );
+
+    dst  += head;
+    src  += head;
+    size -= head;
+
+    for ( ; size >= 128; size -= 128, src += 128, dst += 128 )
+    {
+        _mm_prefetch( ( const char* ) src + STREAM_COPY_PREFETCH, _MM_HINT_T0 );
+        _mm_prefetch( ( const char* ) src + STREAM_COPY_PREFETCH + 64, _MM_HINT_T0 );
+
+        __m256i a = _mm256_loadu_si256( ( const __m256i* ) src );
+        __m256i b = _mm256_loadu_si256( ( const __m256i* ) ( src + 32 ) );
+        __m256i c = _mm256_loadu_si256( ( const __m256i* ) ( src + 64 ) );
+        __m256i d = _mm256_loadu_si256( ( const __m256i* ) ( src + 96 ) );
+
+        _mm256_stream_si256( ( __m256i* ) dst, a );
+        _mm256_stream_si256( ( __m256i* ) ( dst + 32 ), b );
+        _mm256_stream_si256( ( __m256i* ) ( dst + 64 ), c );
+        _mm256_stream_si256( ( __m256i* ) ( dst + 96 ), d );
+    }
+
+    _mm256_zeroupper();
+
+    memcpy( dst, src, size );
+}
+
+#endif
+
+/**
+* copy routine picked for the CPU and the size threshold
+*/
+struct StreamCopyConfig
+{
+    StreamCopyFunc       copy;
+    const char*          isa;
+    std::atomic<size_t>  threshold;
+
+    StreamCopyConfig() : copy( streamCopyPlain ),
+                         isa( "memcpy" ),
+                         threshold( 0 )
+    {
+#ifdef STREAM_COPY_X86
+        __builtin_cpu_init();
+
+        if ( __builtin_cpu_supports( "avx" ) )
+        {
+            copy = streamCopyAvx;
+            isa  = "avx";
+        }
+        else if ( __builtin_cpu_supports( "sse2" ) )
+        {
+            copy = streamCopySse2;
+            isa  = "sse2";
+        }
+#endif
+
+        // a payload larger than the share of a core in the last level cache pushes out the working
+        // sets of the other threads (the same estimate glibc uses for its own non-temporal memcpy)
+        long l2Size = sysconf( _SC_LEVEL2_CACHE_SIZE );
+        long l3Size = sysconf( _SC_LEVEL3_CACHE_SIZE );
+        long noCpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+        long cacheSize = ( ( l3Size > 0 ) && ( noCpus > 0 ) ) ? l3Size / noCpus : 0;
+
+        if ( cacheSize < l2Size )
+            cacheSize = l2Size;
+
+        if ( cacheSize <= 0 )
+            cacheSize = STREAM_COPY_DEFAULT_CACHE;
+
+        threshold = ( copy != streamCopyPlain ) ? cacheSize : 0;
+    }
+};
+
+static StreamCopyConfig&
+streamCopyConfig()
+{
+    static StreamCopyConfig config;
+
+    return config;
+}
+
+bool
+streamCopyUsed( size_t size )
+{
+    size_t threshold = streamCopyConfig().threshold.load( std::memory_order_relaxed );
+
+    return threshold && ( size >= threshold );
+}
+
+void
+streamCopyUnfenced( void* dst, const void* src, size_t size )
+{
+    streamCopyConfig().copy( ( uint8_t* ) dst, ( const uint8_t* ) src, size );
+}
+
+void
+streamCopyFence()
+{
+#ifdef STREAM_COPY_X86
+    _mm_sfence();
+#endif
+}
+
+void
+streamCopy( void* dst, const void* src, size_t size )
+{
+    if ( !streamCopyUsed( size ) )
+    {
+        memcpy( dst, src, size );
+        return;
+    }
+
+    streamCopyUnfenced( dst, src, size );
+    streamCopyFence();
+}
+
+void
+setStreamCopyThreshold( size_t threshold )
+{
+    // without streaming stores, there is nothing to switch to
+    if ( streamCopyConfig().copy == streamCopyPlain )
+        threshold = 0;
+
+    streamCopyConfig().threshold = threshold;
+}
+
+size_t
+getStreamCopyThreshold()
+{
+    return streamCopyConfig().threshold;
+}
+
+const char*
+streamCopyIsa()
+{
+    return streamCopyConfig().isa;
+}
+
+} // namespace Framework
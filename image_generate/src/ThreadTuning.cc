@@ -0,0 +1,136 @@
+/* ===================================================
+ *  file:       ThreadTuning.cc
+ * ---------------------------------------------------
+ *  purpose:	CPU affinity, real-time scheduling and
+ *              memory locking of the reader's threads
+ * ---------------------------------------------------
+ *  first edit:	18.10.2026
+ *  last mod.:  18.10.2026
+ * ===================================================
+ */
+/* ====== INCLUSIONS ====== */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include "ThreadTuning.hh"
+
+namespace Framework
+{
+
+bool
+parseCpuList( const char* list, cpu_set_t & cpus )
+{
+    CPU_ZERO( &cpus );
+
+    if ( !list )
+        return false;
+
+    const char* pos = list;
+
+    while ( *pos )
+    {
+        char* end   = 0;
+        long  first = strtol( pos, &end, 10 );
+        long  last  = first;
+
+        if ( ( end == pos ) || ( first < 0 ) )
+            return false;
+
+        if ( *end == '-' )
+        {
+            pos  = end + 1;
+            last = strtol( pos, &end, 10 );
+
+            if ( ( end == pos ) || ( last < first ) )
+                return false;
+        }
+
+        if ( last >= CPU_SETSIZE )
+            return false;
+
+        for ( long cpu = first; cpu <= last; cpu++ )
+            CPU_SET( cpu, &cpus );
+
+        if ( *end == ',' )
+            end++;
+        else if ( *end )
+            return false;
+
+        pos = end;
+    }
+
+    return CPU_COUNT( &cpus ) > 0;
+}
+
+bool
+setThreadAffinity( pthread_t thread, const cpu_set_t & cpus )
+{
+    int err = pthread_setaffinity_np( thread, sizeof( cpu_set_t ), &cpus );
+
+    if ( err )
+    {
+        fprintf( stderr, "setThreadAffinity: pthread_setaffinity_np(): %s\n", strerror( err ) );
+        return false;
+    }
+
+    return true;
+}
+
+bool
+setThreadRealtime( pthread_t thread, int priority )
+{
+    struct sched_param param;
+
+    memset( &param, 0, sizeof( param ) );
+    param.sched_priority = priority;
+
+    int err = pthread_setschedparam( thread, SCHED_FIFO, &param );
+
+    if ( err )
+    {
+        fprintf( stderr, "setThreadRealtime: pthread_setschedparam(): %s (CAP_SYS_NICE or an rtprio limit is needed)\n", strerror( err ) );
+        return false;
+    }
+
+    return true;
+}
+
+bool
+setThreadNormal( pthread_t thread )
+{
+    struct sched_param param;
+    int                policy;
+
+    if ( pthread_getschedparam( thread, &policy, &param ) || ( policy == SCHED_OTHER ) )
+        return true;
+
+    memset( &param, 0, sizeof( param ) );
+
+    return pthread_setschedparam( thread, SCHED_OTHER, &param ) == 0;
+}
+
+bool
+lockMemory( void* ptr, size_t size )
+{
+    if ( !ptr || !size )
+        return false;
+
+    // mlock() faults the pages in by itself
+    if ( !mlock( ptr, size ) )
+        return true;
+
+    perror( "lockMemory: mlock() (raise the memlock limit to lock the segment)" );
+
+    // at least map all pages now; reading suffices, since the pages of a shared segment exist already
+    long                    pageSize = sysconf( _SC_PAGESIZE );
+    const volatile char*    data     = ( const volatile char* ) ptr;
+
+    for ( size_t offset = 0; offset < size; offset += pageSize )
+        ( void ) data[ offset ];
+
+    return false;
+}
+
+} // namespace Framework